@@ -0,0 +1,221 @@
+#
+# This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+# Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+#
+# Vulpes is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as
+# published by the Free Software Foundation, version 3.
+#
+# Vulpes is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+#
+
+use strict;
+use warnings;
+use Data::Dumper qw( Dumper );
+use Carp qw( confess );
+
+use CodeGen::Shared qw( ensure_number );
+
+use constant FUNCTION_CPP_STD_SOURCE_INCLUDES => [
+    "#include <cstdint>",
+];
+
+use constant FUNCTION_CPP_SOURCE_INCLUDES => [
+    "#include <vulpes/memory/signatures.hpp>",
+];
+
+use constant FUNCTION_CPP_STD_HEADER_INCLUDES => [
+    "#include <cstdint>",
+];
+
+use constant FUNCTION_CPP_HEADER_INCLUDES => [];
+
+# Registers that cdecl callers already expect to lose, so the thunks never
+# need to save these.
+use constant CALLER_SAVED => { eax => 1, ecx => 1, edx => 1 };
+# Registers a thunk has to give back the way it got them, in push order.
+use constant CALLEE_SAVED => [qw( ebx esi edi ebp )];
+
+sub is_register {
+    my ($reg) = @_;
+    return exists CALLER_SAVED->{$reg} || grep { $_ eq $reg } @{+CALLEE_SAVED};
+}
+
+sub preprocess_function {
+    my ($func) = @_;
+
+    unless (exists $func->{name}) {
+        confess "Functions need a name " . Dumper $func;
+    }
+    unless (exists $func->{signature}) {
+        confess "Function $func->{name} needs a signature to get its address from."
+    }
+
+    $func->{returns}         //= "void";
+    $func->{return_register} //= "eax";
+    $func->{clobbers}        //= [];
+    $func->{args}            //= [];
+    $func->{callee_cleans}   //= 0;
+
+    unless (is_register $func->{return_register}) {
+        confess "Function $func->{name} returns in $func->{return_register}, "
+              . "which isn't a register we can use."
+    }
+
+    my %used;
+    my $index = 0;
+    for my $arg (@{$func->{args}}) {
+        if (defined $arg->{value}) {
+            # Fixed values aren't part of the C++ function.
+            $arg->{value} = ensure_number($arg->{value});
+        } else {
+            unless (defined $arg->{name} and defined $arg->{type}) {
+                confess "Argument of function $func->{name} needs a name and "
+                      . "type, or a value. " . Dumper $arg;
+            }
+            $arg->{index} = $index++;
+        }
+        if (defined $arg->{register}) {
+            unless (is_register $arg->{register}) {
+                confess "Function $func->{name} takes an argument in "
+                      . "$arg->{register}, which isn't a register we can use."
+            }
+            if ($used{$arg->{register}}++) {
+                confess "Function $func->{name} takes more than one argument "
+                      . "in $arg->{register}."
+            }
+        }
+    }
+
+    for my $reg (@{$func->{clobbers}}) {
+        unless (is_register $reg) {
+            confess "Function $func->{name} clobbers $reg, which isn't a "
+                  . "register we know."
+        }
+    }
+
+    # Only save registers the caller expects back, and only if something
+    # actually changes them. That's anything the function clobbers, and
+    # anything we put arguments or get the return value in.
+    my %touched = map { $_ => 1 } @{$func->{clobbers}}, keys %used;
+    $touched{$func->{return_register}} = 1 if $func->{returns} ne "void";
+    $func->{saved} = [grep { $touched{$_} } @{+CALLEE_SAVED}];
+
+    return $func;
+}
+
+sub yaml_function_to_asm {
+    my ($func) = @_;
+
+    my @saved = @{$func->{saved}};
+    my @stack = grep { !defined $_->{register} } @{$func->{args}};
+    my @registers = grep { defined $_->{register} } @{$func->{args}};
+
+    my @asm = map { "push $_" } @saved;
+
+    # Where the C++ arguments are, which moves as we push.
+    my $pushed = 0;
+    my $argument = sub {
+        my ($arg) = @_;
+        return sprintf "dword ptr [esp+0x%X]", 4 * (@saved + $pushed + 1 + $arg->{index});
+    };
+
+    # Stack arguments go right to left, like any other call.
+    for my $arg (reverse @stack) {
+        if (defined $arg->{value}) {
+            push @asm, sprintf "push 0x%X", $arg->{value};
+        } else {
+            push @asm, "push " . $argument->($arg);
+        }
+        $pushed++;
+    }
+    for my $arg (@registers) {
+        if (defined $arg->{value}) {
+            push @asm, sprintf "mov %s, 0x%X", $arg->{register}, $arg->{value};
+        } else {
+            push @asm, "mov $arg->{register}, " . $argument->($arg);
+        }
+    }
+
+    push @asm, "call dword ptr [_function_$func->{name}]";
+    if ($pushed and !$func->{callee_cleans}) {
+        push @asm, sprintf "add esp, 0x%X", 4 * $pushed;
+    }
+    if ($func->{returns} ne "void" and $func->{return_register} ne "eax") {
+        push @asm, "mov eax, $func->{return_register}";
+    }
+    push @asm, map { "pop $_" } reverse @saved;
+    push @asm, "ret";
+
+    return join("", map { "    \"    $_\\n\"\n" } @asm);
+}
+
+sub yaml_function_to_cpp_thunk {
+    my ($func) = @_;
+
+    return "asm (\n".
+           "    \".text\\n\"\n".
+           "    \".globl _call_$func->{name}\\n\"\n".
+           "    \".p2align 4\\n\"\n".
+           "    \"_call_$func->{name}:\\n\"\n".
+           yaml_function_to_asm($func).
+           ");\n\n";
+}
+
+sub yaml_function_to_cpp_declaration {
+    my ($func) = @_;
+
+    my @params = map { "$_->{type} $_->{name}" }
+                 grep { !defined $_->{value} } @{$func->{args}};
+    return "extern \"C\" $func->{returns} call_$func->{name}("
+         . join(", ", @params) . ");\n";
+}
+
+sub yaml_functions_to_cpp_definitions {
+    my ($name, $funcs) = @_;
+    my @funcs = map { preprocess_function $_ } @{$funcs};
+
+    my $source_defs = join("",
+        # The addresses the thunks call, filled in on initialization.
+        "extern \"C\" {\n",
+        (map { "    uintptr_t function_$_->{name};\n" } @funcs),
+        "}\n\n",
+        # Thunks are plain assembly, so the compiler can't add anything we
+        # don't need to them.
+        (map { yaml_function_to_cpp_thunk $_ } @funcs));
+
+    my $initialization_code = join("", map {
+        "    function_$_->{name} = reinterpret_cast<uintptr_t>(sig_$_->{signature}());\n"
+    } @funcs);
+
+    my $init_function = qq{void init_$name\_functions() {
+$initialization_code}
+};
+
+    #### Header stuff
+    my $header_defs = join("", (map { yaml_function_to_cpp_declaration $_ } @funcs), "\n");
+    my $header_initializer = "void init_$name\_functions();\n";
+
+    return {
+        source => {
+            std_includes    => FUNCTION_CPP_STD_SOURCE_INCLUDES,
+            includes        => FUNCTION_CPP_SOURCE_INCLUDES,
+            defs            => $source_defs,
+            initializer     => $init_function,
+        },
+        header => {
+            std_includes    => FUNCTION_CPP_STD_HEADER_INCLUDES,
+            includes        => FUNCTION_CPP_HEADER_INCLUDES,
+            defs            => $header_defs,
+            initializer     => $header_initializer,
+        },
+    };
+}
+
+1;
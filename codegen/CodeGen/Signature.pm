@@ -31,6 +31,7 @@ use constant SIGNATURE_CPP_STD_SOURCE_INCLUDES => [
 
 use constant SIGNATURE_CPP_SOURCE_INCLUDES => [
     "#include <hooker/hooker.hpp>",
+    "#include <hooker/signature_scanner.hpp>",
 ];
 
 use constant SIGNATURE_CPP_STD_HEADER_INCLUDES => [
@@ -40,6 +41,49 @@ use constant SIGNATURE_CPP_STD_HEADER_INCLUDES => [
 
 use constant SIGNATURE_CPP_HEADER_INCLUDES => [];
 
+# Bytes that show up the most in 32 bit x86 code, most common first.
+# We avoid these when picking the anchor byte for a signature, as every
+# address where the anchor matches needs a full compare at runtime.
+use constant COMMON_CODE_BYTES => [
+    0x00, 0xFF, 0x8B, 0x24, 0x89, 0x44, 0x04, 0x08, 0x01, 0x0F,
+    0x83, 0xE8, 0x85, 0x10, 0x50, 0x74, 0xC4, 0x0C, 0x4C, 0x54,
+    0x02, 0x14, 0x18, 0x75, 0x56, 0x57, 0x8D, 0xC0, 0x33, 0xC3,
+    0x20, 0xEB, 0x40, 0x5E, 0x5F, 0xC7, 0x03, 0x46, 0x80, 0x84,
+    0x1C, 0x6A, 0x55, 0x53, 0xCC, 0x90, 0xD9, 0xD8, 0x05, 0x15,
+];
+
+# Signatures whose first solid run is at least this long get a skip table.
+# With shorter runs the SSE2 anchor search is usually faster.
+use constant SKIP_TABLE_MIN_RUN => 32;
+
+# Returns how common a byte is in code. Higher is more common.
+sub byte_commonness {
+    my ($byte) = @_;
+    my $common = COMMON_CODE_BYTES;
+    for my $i (0..$#{$common}) {
+        return scalar(@{$common}) - $i if $common->[$i] == $byte;
+    }
+    return 0;
+}
+
+# Returns the offset of the least common non-wildcard byte in the signature.
+sub find_anchor_offset {
+    my ($sig, @bytes) = @_;
+
+    my $anchor;
+    for my $i (0..$#bytes) {
+        next if $bytes[$i] eq "??";
+        if (!defined $anchor
+        or byte_commonness(hex $bytes[$i]) < byte_commonness(hex $bytes[$anchor])) {
+            $anchor = $i;
+        }
+    }
+    unless (defined $anchor) {
+        confess "Signature $sig->{name} has no bytes that aren't wildcards."
+    }
+    return $anchor;
+}
+
 sub preprocess_signature {
     my ($sig) = @_;
 
@@ -52,12 +96,101 @@ sub preprocess_signature {
     $sig->{type}    //= "uintptr_t";
     $sig->{multi}   //= 0;
     $sig->{crucial} //= 0;
+    $sig->{lazy}    //= 0;
+
+    if ($sig->{lazy} and $sig->{crucial}) {
+        confess "Signature $sig->{name} is crucial, so it can't be lazy. "
+              . "Crucial signatures need to be validated on initialization."
+    }
 
     $sig->{ref} = !!$sig->{base};
 
+    # Optional hints for where to search.
+    $sig->{window_start}  = ensure_number($sig->{window_start} // 0);
+    $sig->{window_end}    = ensure_number($sig->{window_end} // 0);
+    $sig->{near_distance} = ensure_number($sig->{near_distance} // 0x1000);
+    $sig->{has_region} = defined $sig->{section}
+                      || $sig->{window_start} || $sig->{window_end}
+                      || defined $sig->{near};
+
+    if (!!$sig->{window_start} != !!$sig->{window_end}) {
+        confess "Signature $sig->{name} needs both window_start and window_end."
+    }
+    if ($sig->{window_end} && $sig->{window_start} >= $sig->{window_end}) {
+        confess "Signature $sig->{name} has a window that ends before it starts."
+    }
+
     return $sig;
 }
 
+# Makes sure every near hint points at a signature we can actually search
+# around, and that they don't go around in circles.
+sub validate_near_hints {
+    my (@sigs) = @_;
+
+    my %by_name = map { $_->{name} => $_ } @sigs;
+    for my $sig (@sigs) {
+        next unless defined $sig->{near};
+        my %seen = ($sig->{name} => 1);
+        my $current = $sig;
+        while (defined $current->{near}) {
+            my $target = $by_name{$current->{near}};
+            unless ($target) {
+                confess "Signature $current->{name} is near $current->{near}, "
+                      . "which doesn't exist in this file."
+            }
+            if ($target->{ref} or $target->{multi}) {
+                confess "Signature $current->{name} can only be near a "
+                      . "signature with a single result of its own."
+            }
+            if ($target->{lazy} and !$current->{lazy}) {
+                confess "Signature $current->{name} is near $target->{name}, "
+                      . "which is lazy, so it needs to be lazy too."
+            }
+            if ($seen{$target->{name}}++) {
+                confess "Signature $sig->{name} has near hints that loop back "
+                      . "around to themselves."
+            }
+            $current = $target;
+        }
+    }
+}
+
+# Returns how many bytes at the start of the signature aren't wildcards.
+sub find_solid_run {
+    my (@bytes) = @_;
+
+    my $run = 0;
+    $run++ while $run < @bytes and $bytes[$run] ne "??";
+    return $run;
+}
+
+# Returns a Horspool shift table for the first solid run of the signature.
+# Entry n says how far a search can move along when the byte at the end of
+# the run is n.
+sub build_skip_table {
+    my ($run, @bytes) = @_;
+
+    my $default = $run > 255 ? 255 : $run;
+    my @skip = ($default) x 256;
+    for my $i (0..$run - 2) {
+        my $shift = $run - 1 - $i;
+        $skip[hex $bytes[$i]] = $shift > 255 ? 255 : $shift;
+    }
+    return @skip;
+}
+
+# Formats a list of C++ values into lines of 16.
+sub format_byte_table {
+    my (@values) = @_;
+
+    my @lines;
+    while (my @line = splice @values, 0, 16) {
+        push @lines, "    " . join(", ", @line);
+    }
+    return join(",\n", @lines);
+}
+
 sub yaml_sig_to_cpp_sig {
     my ($sig) = @_;
 
@@ -69,14 +202,33 @@ sub yaml_sig_to_cpp_sig {
     unless ($sig->{bytes} =~ /^\s*(?:(?:\?\?|[[:xdigit:]]{2})\s??\s*)+$/) {
         confess "Signature $sig->{name} has an invalid byte pattern."
     }
-    # Convert string to individual parts and then convert them into C++ format.
-    my @bytes = map {$_ eq "??" ? "-1" : "0x$_"} split /\s+/, $sig->{bytes};
-    # Combine the bytes into a single string.
-    my $byte_str = join(", ", @bytes);
+    # Split the string into the individual bytes.
+    my @parts = split /\s+/, $sig->{bytes};
+    # Pick what byte our searches should look for first.
+    my $anchor = find_anchor_offset $sig, @parts;
+    my $solid_run = find_solid_run @parts;
+    # Convert the bytes into packed values and masks, wildcards are 0 in both.
+    my @values = map {$_ eq "??" ? "0x00" : "0x$_"} @parts;
+    my @masks  = map {$_ eq "??" ? "0x00" : "0xFF"} @parts;
     # Get amount of bytes.
-    my $len = scalar @bytes;
-    return "static LiteSignature signature_$sig->{name} = ".
-           "{ \"$sig->{name}\", $len, { $byte_str } };\n";
+    my $len = scalar @parts;
+
+    my $prefix = "signature_$sig->{name}";
+    my $tables = "static constexpr uint8_t $prefix\_values[] = { "
+               . join(", ", @values) . " };\n"
+               . "static constexpr uint8_t $prefix\_masks[] = { "
+               . join(", ", @masks) . " };\n";
+    # Short runs don't let a search skip far enough to be worth the space.
+    my $skip = "NULL";
+    if ($solid_run >= SKIP_TABLE_MIN_RUN) {
+        $skip = "$prefix\_skip";
+        $tables .= "static constexpr uint8_t $skip\[256] = {\n"
+                 . format_byte_table(build_skip_table $solid_run, @parts)
+                 . "\n};\n";
+    }
+    return $tables .
+           "static LiteSignature $prefix = { \"$sig->{name}\", $len, ".
+           "$prefix\_values, $prefix\_masks, $anchor, $solid_run, $skip };\n";
 }
 
 sub yaml_sig_to_cpp_initializer {
@@ -86,10 +238,29 @@ sub yaml_sig_to_cpp_initializer {
         # References are initialized when the thing they reference is initialized.
         return "";
     }
+    if ($sig->{lazy}) {
+        # Lazy signatures are searched for when their getter is first used.
+        return "";
+    }
+    my $region = yaml_sig_to_cpp_region($sig);
     if ($sig->{multi}) {
-        return "    PTRS_$sig->{uc_name} = signature_$sig->{name}.search_multiple();\n";
+        return "    scanner.add_multiple(&signature_$sig->{name}, &PTRS_$sig->{uc_name}$region);\n";
     }
-    return "    PTR_$sig->{uc_name} = signature_$sig->{name}.search();\n";
+    return "    scanner.add(&signature_$sig->{name}, &PTR_$sig->{uc_name}$region);\n";
+}
+
+# Returns the SignatureRegion argument for signatures that have hints for
+# where to search.
+sub yaml_sig_to_cpp_region {
+    my ($sig) = @_;
+
+    return "" unless $sig->{has_region};
+
+    my $section = defined $sig->{section} ? "\"$sig->{section}\"" : "NULL";
+    my $near = defined $sig->{near} ? "&PTR_" . uc $sig->{near} : "NULL";
+    return sprintf(", { %s, 0x%X, 0x%X, %s, 0x%X }",
+        $section, $sig->{window_start}, $sig->{window_end},
+        $near, $sig->{near_distance});
 }
 
 sub yaml_sig_to_cpp_validator {
@@ -99,6 +270,10 @@ sub yaml_sig_to_cpp_validator {
         # References don't need validators.
         return "";
     }
+    if ($sig->{lazy}) {
+        # Lazy signatures report themselves missing once they're searched for.
+        return "";
+    }
     my $validator = "";
     if ($sig->{multi}) {
         $validator .= "    if (PTRS_$sig->{uc_name}.empty())\n";
@@ -121,10 +296,39 @@ sub yaml_sig_to_cpp_address_var {
         # References use the address of whatever they reference
         return "";
     }
+    my $var;
+    if ($sig->{multi}) {
+        $var = "static std::vector<uintptr_t> PTRS_$sig->{uc_name};\n";
+    } else {
+        $var = "static uintptr_t PTR_$sig->{uc_name};\n";
+    }
+    if ($sig->{lazy}) {
+        # Remembers whether we searched already, as not found is a result too.
+        $var .= "static bool RESOLVED_$sig->{uc_name} = false;\n";
+    }
+    return $var;
+}
+
+# Returns the code a lazy getter runs to find its signature the first time.
+sub yaml_sig_to_cpp_lazy_resolver {
+    my ($sig) = @_;
+
+    return "" unless $sig->{lazy};
+
+    my $region = yaml_sig_to_cpp_region($sig);
+    my $resolver = "    if (!RESOLVED_$sig->{uc_name}) {\n";
+    # A lazy signature we're near might not have been searched for yet.
+    if (defined $sig->{near}) {
+        $resolver .= "        sig_$sig->{near}();\n";
+    }
     if ($sig->{multi}) {
-        return "static std::vector<uintptr_t> PTRS_$sig->{uc_name};\n";
+        $resolver .= "        resolve_lazy_signature_multiple(&signature_$sig->{name}, "
+                   . "&PTRS_$sig->{uc_name}, &RESOLVED_$sig->{uc_name}$region);\n";
+    } else {
+        $resolver .= "        resolve_lazy_signature(&signature_$sig->{name}, "
+                   . "&PTR_$sig->{uc_name}, &RESOLVED_$sig->{uc_name}$region);\n";
     }
-    return "static uintptr_t PTR_$sig->{uc_name};\n";
+    return $resolver . "    }\n";
 }
 
 sub yaml_sig_to_cpp_getter {
@@ -138,12 +342,15 @@ sub yaml_sig_to_cpp_getter {
                "}\n";
     }
 
+    my $resolver = yaml_sig_to_cpp_lazy_resolver($sig);
     if ($sig->{multi}) {
         return "std::vector<uintptr_t> sig_$sig->{name}() {\n".
+               $resolver.
                "    return PTRS_$sig->{uc_name};\n".
                "}\n";
     }
     return "$sig->{type} sig_$sig->{name}() {\n".
+           $resolver.
            "    return reinterpret_cast<$sig->{type}>(\n".
            "        PTR_$sig->{uc_name} ?\n".
            "            (PTR_$sig->{uc_name} + $sig->{offset}) : NULL);\n".
@@ -163,6 +370,7 @@ sub yaml_sig_to_cpp_getter_header {
 sub yaml_signatures_to_cpp_definitions {
     my ($name, $sigs) = @_;
     my @sigs = map { preprocess_signature $_ } @{$sigs};
+    validate_near_hints @sigs;
 
     my $source_defs = join("",
         # Actual signature definitions
@@ -177,8 +385,10 @@ sub yaml_signatures_to_cpp_definitions {
 
     # Function called on initialization.
     my $init_function = qq{void init_$name\_signatures() {
-    // Write signature results to our variables for safekeeping.
-$initialization_code
+    // Queue up all signatures so they can be found in a single pass.
+    // The scanner writes the results to our variables for safekeeping.
+    SignatureScanner scanner;
+$initialization_code    scanner.scan();
 
     // Find out if we failed to find any signatures.
     std::vector<const char*> crucial_missing;
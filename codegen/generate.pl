@@ -21,7 +21,7 @@ use warnings;
 
 # If you see a pull request that changes this system and it does not
 # have a change for this constant you should ready the firing squad.
-our $VERSION = '1.3.0';
+our $VERSION = '1.9.0';
 
 use Digest::SHA1 qw( sha1_base64 );
 use File::Basename qw( dirname basename fileparse );
@@ -36,6 +36,7 @@ use CodeGen::Signature qw( yaml_signatures_to_cpp_definitions );
 use CodeGen::Enum qw( yaml_enums_to_cpp_definitions );
 use CodeGen::Struct qw( yaml_structs_to_cpp_definitions );
 use CodeGen::Bitfield qw( yaml_bitfields_to_cpp_definitions );
+use CodeGen::Function qw( yaml_functions_to_cpp_definitions );
 
 sub gen_header {
     my $name = shift;
@@ -152,6 +153,10 @@ foreach my $filepath (@ARGV) {
         push @outputs, yaml_signatures_to_cpp_definitions $name, $file->{signatures};
     }
 
+    if (exists $file->{functions}) {
+        push @outputs, yaml_functions_to_cpp_definitions $name, $file->{functions};
+    }
+
     foreach my $output (@outputs){
         push @src_std_includes, @{$output->{source}->{std_includes}};
         push @src_includes, @{$output->{source}->{includes}};
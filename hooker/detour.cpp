@@ -0,0 +1,218 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include "detour.hpp"
+#include "memory_protection.hpp"
+#include "x86_decoder.hpp"
+
+// Thunks and trampolines are tiny, so they get packed into shared blocks.
+// They are never freed, a revert only takes the jump out, so a thread that
+// is still inside of one can always finish.
+static uintptr_t allocate_code(size_t size) {
+    static uintptr_t block = 0;
+    static size_t block_left = 0;
+
+    size = (size + 15) & ~size_t(15);
+    if (size > block_left) {
+        auto protection = get_memory_protection();
+        size_t page_size = protection->page_size();
+        size_t block_size = (size + page_size - 1) & ~(page_size - 1);
+        block = protection->allocate_executable(block_size);
+        if (!block) return 0;
+        block_left = block_size;
+    }
+    uintptr_t address = block;
+    block += size;
+    block_left -= size;
+    return address;
+}
+
+// Writes machine code meant to end up at base, so relative addresses can be
+// worked out while writing.
+class CodeWriter {
+public:
+    CodeWriter(uintptr_t base) : base(base) {}
+
+    void bytes(std::initializer_list<uint8_t> list) {
+        code.insert(code.end(), list);
+    }
+    void dword(uint32_t value) {
+        uint8_t data[4];
+        memcpy(data, &value, 4);
+        code.insert(code.end(), data, data + 4);
+    }
+    // A rel32 aimed at target, for the instruction that ends with it.
+    void rel32(uintptr_t target) {
+        dword(target - (here() + 4));
+    }
+    void call(uintptr_t target) {
+        bytes({CALL_BYTE});
+        rel32(target);
+    }
+    void jmp(uintptr_t target) {
+        bytes({JMP_BYTE});
+        rel32(target);
+    }
+    // add esp, amount
+    void add_esp(uint32_t amount) {
+        if (amount == 0) return;
+        if (amount < 0x80) {
+            bytes({0x83, 0xC4, uint8_t(amount)});
+        } else {
+            bytes({0x81, 0xC4});
+            dword(amount);
+        }
+    }
+    uintptr_t here() {
+        return base + code.size();
+    }
+
+    uintptr_t base;
+    std::vector<uint8_t> code;
+};
+
+// How far we look for the end of a function we hook.
+static const size_t MAX_FUNCTION_SCAN = 0x10000;
+
+// Largest a thunk can get, with the after hook and argument copying.
+static size_t thunk_size(size_t arguments) {
+    return 64 + arguments * 7;
+}
+
+static void write_thunk(CodeWriter* thunk, uintptr_t before, uintptr_t after,
+                        size_t arguments, uintptr_t trampoline) {
+    size_t cancel_jump = 0;
+    if (before) {
+        thunk->bytes({0x50, 0x51, 0x52});       // push eax; push ecx; push edx
+        thunk->bytes({0x8D, 0x44, 0x24, 0x10}); // lea eax, [esp+0x10]
+        thunk->bytes({0x50});                   // push eax
+        thunk->call(before);
+        thunk->add_esp(4);
+        thunk->bytes({0x84, 0xC0});             // test al, al
+        thunk->bytes({0x5A, 0x59, 0x58});       // pop edx; pop ecx; pop eax
+        thunk->bytes({0x0F, 0x84});             // jz cancel
+        cancel_jump = thunk->code.size();
+        thunk->dword(0);
+    }
+
+    if (!after) {
+        thunk->jmp(trampoline);
+    } else {
+        // Every push moves esp, so the same offset gets the next argument.
+        uint32_t offset = arguments * 4;
+        for (size_t i = 0; i < arguments; i++) {
+            if (offset < 0x80) {
+                thunk->bytes({0xFF, 0x74, 0x24, uint8_t(offset)});
+            } else {
+                thunk->bytes({0xFF, 0xB4, 0x24});
+                thunk->dword(offset);
+            }
+        }
+        thunk->call(trampoline);
+        thunk->add_esp(arguments * 4);
+        thunk->bytes({0x51, 0x52, 0x50, 0x54}); // push ecx; push edx; push eax; push esp
+        thunk->call(after);
+        thunk->add_esp(4);
+        thunk->bytes({0x58, 0x5A, 0x59});       // pop eax; pop edx; pop ecx
+        thunk->bytes({0xC3});                   // ret
+    }
+
+    if (before) {
+        uint32_t distance = thunk->code.size() - (cancel_jump + 4);
+        memcpy(&thunk->code[cancel_jump], &distance, 4);
+        thunk->bytes({0xC3});                   // cancel: ret
+    }
+}
+
+bool Detour::build(uintptr_t p_address) {
+    if (patch) return true;
+    printf("Build Detour %s\n", name);
+    if (!p_address) {
+        printf("Couldn't build. Invalid address.\n");
+        return false;
+    }
+
+    // Cancelling returns with a plain ret and the after hook calls the
+    // function as cdecl, both would unbalance the stack otherwise.
+    uint16_t popped;
+    if (!x86_find_return(p_address, MAX_FUNCTION_SCAN, &popped)) {
+        printf("Couldn't build. Can't find where the function returns.\n");
+        return false;
+    }
+    if (popped) {
+        printf("Couldn't build. The function pops its own arguments.\n");
+        return false;
+    }
+
+    // We need room for a jmp, but can only take whole instructions.
+    size_t stolen = x86_instructions_size(p_address, 5);
+    if (!stolen) {
+        printf("Couldn't build. Unknown instructions.\n");
+        return false;
+    }
+
+    // Short branches grow into long ones, which at most triples their size.
+    uintptr_t code = allocate_code(stolen * 3 + 5 + thunk_size(arguments));
+    if (!code) {
+        printf("Couldn't build. Out of executable memory.\n");
+        return false;
+    }
+
+    CodeWriter trampoline(code);
+    if (!x86_relocate(p_address, stolen, code, &trampoline.code)) {
+        printf("Couldn't build. The instructions can't be moved.\n");
+        return false;
+    }
+    trampoline.jmp(p_address + stolen);
+
+    CodeWriter thunk(code + trampoline.code.size());
+    write_thunk(&thunk, before_address, after_address, arguments, code);
+
+    memcpy(reinterpret_cast<void*>(trampoline.base),
+           trampoline.code.data(), trampoline.code.size());
+    memcpy(reinterpret_cast<void*>(thunk.base),
+           thunk.code.data(), thunk.code.size());
+    trampoline_address = code;
+
+    patch.reset(new CodePatch(name, p_address, stolen, JMP_PATCH, thunk.base));
+    return patch->build();
+}
+
+void Detour::apply() {
+    if (patch) patch->apply();
+}
+
+void Detour::revert() {
+    if (patch) patch->revert();
+}
+
+bool Detour::is_built() {
+    return patch && patch->is_built();
+}
+
+bool Detour::applied() {
+    return patch && patch->applied();
+}
+
+uintptr_t Detour::trampoline() {
+    return trampoline_address;
+}
@@ -0,0 +1,82 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "hooker.hpp"
+
+// A macro so we don't have to fill in the name twice.
+#define DetourHook(name, ...) Detour name(#name, __VA_ARGS__)
+
+// Hooks the start of a cdecl function without any hand written assembly.
+//
+// The first instructions of the function get replaced by a jump to a
+// generated thunk. The instructions that got overwritten are moved to a
+// trampoline that jumps back into the function, so the original still runs.
+//
+// The thunk calls before(args) with a pointer to the stack arguments,
+// returning false from it cancels the call. If there is an after hook the
+// function gets called with stack_arguments copied arguments, and then
+// after(result) gets a pointer to eax, which it can change.
+// Either hook can be NULL. Only eax, ecx and edx are saved around the hooks,
+// the rest is saved by them as cdecl requires.
+//
+// Functions that pop their own arguments can't be detoured, build refuses
+// them.
+class Detour {
+public:
+    template<typename B, typename A>
+    Detour(const char* d_name, B before, A after, size_t stack_arguments = 0) {
+        name = d_name;
+        before_address = function_address(before);
+        after_address = function_address(after);
+        arguments = stack_arguments;
+    }
+
+    // Generates the thunk and trampoline for the function at p_address and
+    // builds the patch that jumps there. Returns true if success or if
+    // already built. This does not apply the detour.
+    bool build(uintptr_t p_address);
+    // Applies and reverts the jump. Queued if a PatchSet is open.
+    void apply();
+    void revert();
+
+    bool is_built();
+    bool applied();
+    // Calling this calls the original function, skipping our hooks.
+    uintptr_t trampoline();
+private:
+    const char* name;
+    uintptr_t before_address;
+    uintptr_t after_address;
+    size_t arguments;
+    uintptr_t trampoline_address = 0;
+    std::unique_ptr<CodePatch> patch;
+
+    // Same as with CodePatch, every function signature is a different type.
+    template<typename T>
+    static uintptr_t function_address(T function) {
+        return *reinterpret_cast<const uintptr_t*>(&function);
+    }
+    static uintptr_t function_address(std::nullptr_t) {
+        return 0;
+    }
+};
@@ -17,48 +17,122 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cstring>
+#include <emmintrin.h>
 #include <iostream>
 #include <string>
-#include <windows.h>
 
 #include "hooker.hpp"
+#include "memory_protection.hpp"
+#include "patch_set.hpp"
 
-uintptr_t LiteSignature::search(
+static bool quiet_signature_search = false;
+
+void set_signature_search_quiet(bool quiet) {
+    quiet_signature_search = quiet;
+}
+
+bool signature_search_quiet() {
+    return quiet_signature_search;
+}
+
+bool LiteSignature::matches(uintptr_t address) {
+    const uint8_t* cur_bytes = reinterpret_cast<const uint8_t*>(address);
+    if (memcmp(cur_bytes, values, solid_run) != 0) {
+        return false;
+    }
+    for (size_t i = solid_run; i < size; i++) {
+        // Wildcards have a mask of 0, so they match anything.
+        if ((cur_bytes[i] & masks[i]) != values[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Finds the first address from start_address up to and including last_start
+// where the signature matches, using the skip table of its first solid run.
+//
+// We only look at the byte at the end of the run. The table tells us how far
+// we can move along before that byte could line up with the run again.
+static uintptr_t find_next_match_skip(LiteSignature* sig,
+        uintptr_t start_address, uintptr_t last_start) {
+
+    const size_t run_end = sig->solid_run - 1;
+    const uint8_t run_end_byte = sig->values[run_end];
+
+    uintptr_t current_start = start_address;
+    while (current_start <= last_start) {
+        uint8_t byte = *reinterpret_cast<const uint8_t*>(current_start + run_end);
+        if (byte == run_end_byte && sig->matches(current_start)) {
+            return current_start;
+        }
+        current_start += sig->skip[byte];
+    }
+    return 0;
+}
+
+// Finds the first address in [start_address, end_address) where the signature
+// fits and matches.
+//
+// Instead of comparing the whole signature at every address we look for its
+// anchor byte 16 addresses at a time using SSE2. Only the addresses where the
+// anchor byte matches get the full compare.
+static uintptr_t find_next_match(LiteSignature* sig,
         uintptr_t start_address, uintptr_t end_address) {
 
-    if (!start_address) start_address = get_lowest_permitted_address();
-    if (!end_address) end_address = get_highest_permitted_address();
+    if (end_address < start_address + sig->size) return 0;
+    // Last address the signature still fits at.
+    uintptr_t last_start = end_address - sig->size;
 
-    printf("Search for sig %s\nAddress range: %8X - %8X\n",
-        this->name, start_address, end_address);
-
-    uintptr_t result = NULL;
-
-    uintptr_t current_address = start_address;
-    while (!result && current_address - this->size <= end_address) {
-        bool mismatch = false;
-        uint8_t* cur_bytes = reinterpret_cast<uint8_t*>(current_address);
-        // For each address we go through our set of bytes until
-        // we get a mismatch or we reach the end of our signature.
-        for (size_t j=0; j < this->size && !mismatch; j++) {
-            // If the current element in our sig is -1 we skip this byte as -1
-            // is our wildcard.
-            if (bytes[j] != -1 && cur_bytes[j] != this->bytes[j]) {
-                mismatch = true;
+    if (sig->skip) {
+        return find_next_match_skip(sig, start_address, last_start);
+    }
+
+    const __m128i anchor_byte = _mm_set1_epi8(
+        static_cast<char>(sig->values[sig->anchor]));
+
+    uintptr_t current_start = start_address;
+    while (current_start + 16 <= last_start + 1) {
+        // Every set bit in this mask is a position where the anchor matches.
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(current_start + sig->anchor));
+        uint32_t hits = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, anchor_byte));
+        while (hits) {
+            uintptr_t candidate = current_start + __builtin_ctz(hits);
+            if (sig->matches(candidate)) {
+                return candidate;
             }
+            // Clear the lowest set bit and try the next candidate.
+            hits &= hits - 1;
         }
-        // If there was no mismatch then we have succesfully found the address.
-        if (!mismatch) {
-            result = current_address;
+        current_start += 16;
+    }
+    // Whatever is left doesn't fill a whole vector.
+    for (; current_start <= last_start; current_start++) {
+        if (sig->matches(current_start)) {
+            return current_start;
         }
-        // If not, then keep searching.
-        current_address++;
     }
+    return 0;
+}
 
-    if (!result) {
-        printf("Not found.\n\n");
-    } else {
-        printf("Found at: %8X\n\n", result);
+uintptr_t LiteSignature::search(
+        uintptr_t start_address, uintptr_t end_address) {
+
+    if (!start_address) start_address = get_lowest_permitted_address();
+    if (!end_address) end_address = get_highest_permitted_address();
+
+    uintptr_t result = find_next_match(this, start_address, end_address);
+
+    if (!quiet_signature_search) {
+        printf("Search for sig %s\nAddress range: %8X - %8X\n",
+            this->name, start_address, end_address);
+        if (!result) {
+            printf("Not found.\n\n");
+        } else {
+            printf("Found at: %8X\n\n", result);
+        }
     }
 
     return result;
@@ -70,19 +144,19 @@ std::vector<uintptr_t> LiteSignature::search_multiple(uintptr_t start_address,
     if (!start_address) start_address = get_lowest_permitted_address();
     if (!end_address) end_address = get_highest_permitted_address();
 
-    printf("Multi sig search for %s\n\n", name);
-
     std::vector<uintptr_t> addresses;
 
-    uintptr_t last_result = 1;
-    while(last_result && start_address + size < end_address) {
-        last_result = search(start_address, end_address);
-        if (last_result) {
-            addresses.push_back(last_result);
-        }
-        start_address = last_result + 1;
+    // Keep streaming through the range from right after the last hit.
+    uintptr_t result = find_next_match(this, start_address, end_address);
+    while (result) {
+        addresses.push_back(result);
+        result = find_next_match(this, result + 1, end_address);
+    }
+
+    if (!quiet_signature_search) {
+        printf("Multi sig search for %s\n", name);
+        printf("Found %d addresses.\n\n", addresses.size());
     }
-    printf("Found %d addresses.\n", addresses.size());
 
     return addresses;
 }
@@ -201,46 +275,37 @@ uintptr_t CodePatch::address() {
     return patch_address;
 }
 
-void CodePatch::write_patch(std::vector<int16_t> patch_code) {
+void CodePatch::write_bytes(const std::vector<int16_t>& patch_code) {
     assert(patch_built);
     uint8_t* patch_address_bytes = reinterpret_cast<uint8_t*>(patch_address);
-    DWORD prota, protb;
-    VirtualProtect(
-        reinterpret_cast<void*>(patch_address),
-        patch_size,
-        PAGE_EXECUTE_READWRITE,
-        &prota
-    );
     for (int i = 0; i < patch_size; i++) {
         if (patch_code[i] != -1) {
             patch_address_bytes[i] = static_cast<uint8_t>(patch_code[i]);
         }
     }
-    VirtualProtect(
-        reinterpret_cast<void*>(patch_address),
-        patch_size,
-        prota,
-        &protb
-    );
 }
 
 void CodePatch::apply() {
-    printf("Apply CodePatch %s\n", name);
     assert(patch_built);
-    write_patch(patched_code);
-    patch_applied = true;
-    printf("Applied.\n");
+    auto open_set = get_open_patch_set();
+    if (open_set) {
+        open_set->apply(this);
+        return;
+    }
+    PatchSet set;
+    set.apply(this);
+    set.commit();
 }
 
 void CodePatch::revert() {
-    printf("Revert CodePatch %s", name);
-    if (patch_applied) {
-        write_patch(original_code);
-        printf("Reverted.\n");
-    } else {
-        printf("No need.\n");
+    auto open_set = get_open_patch_set();
+    if (open_set) {
+        open_set->revert(this);
+        return;
     }
-    patch_applied = false;
+    PatchSet set;
+    set.revert(this);
+    set.commit();
 }
 
 bool CodePatch::integrity() {
@@ -253,7 +318,9 @@ bool CodePatch::integrity() {
 
     bool intact = true;
     for (int i = 0; i < patch_size; i++) {
-        if (patch_address_bytes[i] == comparison_code[i]) {
+        // Wildcards were never written, so whatever is there is fine.
+        if (comparison_code[i] == -1
+        || patch_address_bytes[i] == comparison_code[i]) {
             continue;
         } else {
             intact = false;
@@ -303,17 +370,18 @@ uintptr_t get_call_address(intptr_t call_pointer) {
 }
 
 void set_call_address(intptr_t call_pointer, intptr_t point_to) {
-    DWORD prota, protb;
+    auto protection = get_memory_protection();
+    uint32_t old_protection;
     uint8_t* call_bytes = reinterpret_cast<uint8_t*>(call_pointer);
     assert(call_bytes[0] == CALL_BYTE || call_bytes[0] == JMP_BYTE || call_bytes[0] == CONDJ_BYTE);
     if (call_bytes[0] == CALL_BYTE || call_bytes[0] == JMP_BYTE) {
-        VirtualProtect(reinterpret_cast<void*>(call_pointer), 5, PAGE_EXECUTE_READWRITE, &prota);
+        protection->make_writable(call_pointer, 5, &old_protection);
         *reinterpret_cast<intptr_t*>(call_pointer + 1) = point_to - 5 - call_pointer;
-        VirtualProtect(reinterpret_cast<void*>(call_pointer), 5, prota, &protb);
+        protection->restore(call_pointer, 5, old_protection);
     } else if(call_bytes[0] == CONDJ_BYTE) {
-        VirtualProtect(reinterpret_cast<void*>(call_pointer), 6, PAGE_EXECUTE_READWRITE, &prota);
+        protection->make_writable(call_pointer, 6, &old_protection);
         *reinterpret_cast<intptr_t*>(call_pointer + 2) = point_to - 6 - call_pointer;
-        VirtualProtect(reinterpret_cast<void*>(call_pointer), 6, prota, &protb);
+        protection->restore(call_pointer, 6, old_protection);
     }
 }
 
@@ -38,18 +38,40 @@ enum InstructionBytes : uint8_t {
     JA_BYTE    = 0x87
 };
 
+// Signatures are generated as packed tables by CodeGen, everything a search
+// needs is worked out at compile time.
 class LiteSignature {
 public:
     const char* name;
     const size_t size;
-    const int16_t bytes[];
+    // The bytes to look for. Wildcards are 0x00 here.
+    const uint8_t* values;
+    // 0xFF for bytes that need to match, 0x00 for wildcards.
+    const uint8_t* masks;
+    // Offset of the least common non-wildcard byte in the signature.
+    // Searches only do a full compare where this byte matches.
+    const size_t anchor;
+    // How many bytes at the start of the signature aren't wildcards.
+    // These get compared in one go before the masked compare.
+    const size_t solid_run;
+    // Horspool shift table for the first solid run, indexed by the byte
+    // found at the end of it. NULL unless the run is long enough for
+    // skipping to beat the anchor search.
+    const uint8_t* skip;
 
     uintptr_t search(
         uintptr_t start_address = 0, uintptr_t end_address = 0);
     std::vector<uintptr_t> search_multiple(
         uintptr_t start_address = 0, uintptr_t end_address = 0);
+    // Checks if the signature matches the bytes at the given address.
+    bool matches(uintptr_t address);
 };
 
+// Stops signature searches from logging every signature they look for.
+// Missing signatures are still reported by whoever needed them.
+void set_signature_search_quiet(bool quiet);
+bool signature_search_quiet();
+
 enum PatchTypes {
     NOP_PATCH,   // NOPs out the code so it does nothing.
     CALL_PATCH,  // Makes a function call to redirect_to.
@@ -125,8 +147,13 @@ public:
     // This does not apply the patch.
     bool build(uintptr_t p_address = 0);
     // Applies the patch.
+    // If a PatchSet is open this is queued in it instead, and nothing is
+    // written until it is committed. init_vulpes keeps one open around all of
+    // the init_* functions, so code in there that reads or changes the bytes
+    // of a patch it just applied still sees the original code.
     void apply();
     // Reverts the code to the original bytes.
+    // If a PatchSet is open this is queued in it instead.
     void revert();
     // Returns the address that comes right after the code patch.
     // For use in return jumps found in hooks.
@@ -158,11 +185,17 @@ private:
     bool patch_applied = false;
     PatchTypes type;
     const char* name;
-    void write_patch(std::vector<int16_t> patch_code);
+    // Writes the bytes without touching memory protection.
+    void write_bytes(const std::vector<int16_t>& patch_code);
+    friend class PatchSet;
 };
 
 // Gets the direct pointer to whatever the instruction at this address CALLs or JUMPs to.
 uintptr_t get_call_address(intptr_t call_pointer);
+// Changes where the instruction at this address CALLs or JUMPs to.
+// This always writes right away, even while a PatchSet is open. So don't use
+// it on bytes a queued patch is going to write, or on an instruction a queued
+// patch puts there. Commit the set first if you need to.
 void      set_call_address(intptr_t call_pointer, intptr_t point_to);
 
 template<typename T>
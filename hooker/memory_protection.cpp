@@ -0,0 +1,101 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "memory_protection.hpp"
+
+#ifdef _WIN32
+
+bool SystemMemoryProtection::make_writable(uintptr_t address, size_t size,
+                                           uint32_t* old_protection) {
+    DWORD old;
+    bool success = VirtualProtect(reinterpret_cast<void*>(address), size,
+                                  PAGE_EXECUTE_READWRITE, &old);
+    *old_protection = old;
+    return success;
+}
+
+bool SystemMemoryProtection::restore(uintptr_t address, size_t size,
+                                     uint32_t old_protection) {
+    DWORD unused;
+    return VirtualProtect(reinterpret_cast<void*>(address), size,
+                          old_protection, &unused);
+}
+
+size_t SystemMemoryProtection::page_size() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+uintptr_t SystemMemoryProtection::allocate_executable(size_t size) {
+    return reinterpret_cast<uintptr_t>(VirtualAlloc(NULL, size,
+        MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+}
+
+#else
+
+// mprotect only works on whole pages.
+static void align_to_pages(uintptr_t* address, size_t* size, size_t page_size) {
+    uintptr_t start = *address & ~(page_size - 1);
+    *size += *address - start;
+    *address = start;
+}
+
+bool SystemMemoryProtection::make_writable(uintptr_t address, size_t size,
+                                           uint32_t* old_protection) {
+    align_to_pages(&address, &size, page_size());
+    *old_protection = PROT_READ | PROT_EXEC;
+    return mprotect(reinterpret_cast<void*>(address), size,
+                    PROT_READ | PROT_WRITE | PROT_EXEC) == 0;
+}
+
+bool SystemMemoryProtection::restore(uintptr_t address, size_t size,
+                                     uint32_t old_protection) {
+    align_to_pages(&address, &size, page_size());
+    return mprotect(reinterpret_cast<void*>(address), size, old_protection) == 0;
+}
+
+size_t SystemMemoryProtection::page_size() {
+    return sysconf(_SC_PAGESIZE);
+}
+
+uintptr_t SystemMemoryProtection::allocate_executable(size_t size) {
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return 0;
+    return reinterpret_cast<uintptr_t>(memory);
+}
+
+#endif
+
+static SystemMemoryProtection system_memory_protection;
+static MemoryProtection* memory_protection = &system_memory_protection;
+
+MemoryProtection* get_memory_protection() {
+    return memory_protection;
+}
+
+void set_memory_protection(MemoryProtection* protection) {
+    memory_protection = protection;
+}
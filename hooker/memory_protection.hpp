@@ -0,0 +1,59 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Everything patching needs from the OS to be able to write to code.
+// It is behind this interface so the patching code can also run on systems
+// that don't have VirtualProtect.
+class MemoryProtection {
+public:
+    virtual ~MemoryProtection() {}
+
+    // Makes the range writable. Whatever the protection was before is written
+    // to old_protection so it can be restored afterwards.
+    virtual bool make_writable(uintptr_t address, size_t size,
+                               uint32_t* old_protection) = 0;
+    // Puts back the protection make_writable gave us.
+    virtual bool restore(uintptr_t address, size_t size,
+                         uint32_t old_protection) = 0;
+    // The size of the blocks protection is changed in.
+    virtual size_t page_size() = 0;
+    // Gets fresh memory that can be written to and executed, for code we
+    // generate ourselves. Returns 0 on failure.
+    virtual uintptr_t allocate_executable(size_t size) = 0;
+};
+
+// Uses VirtualProtect on Windows and mprotect everywhere else.
+// mprotect can't tell us what the old protection was, so it assumes code
+// that is readable and executable, which is what we patch.
+class SystemMemoryProtection : public MemoryProtection {
+public:
+    bool make_writable(uintptr_t address, size_t size,
+                       uint32_t* old_protection) override;
+    bool restore(uintptr_t address, size_t size,
+                 uint32_t old_protection) override;
+    size_t page_size() override;
+    uintptr_t allocate_executable(size_t size) override;
+};
+
+// The backend that patches use. Defaults to SystemMemoryProtection.
+MemoryProtection* get_memory_protection();
+void set_memory_protection(MemoryProtection* protection);
@@ -0,0 +1,102 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <map>
+
+#include "memory_protection.hpp"
+#include "patch_set.hpp"
+
+void PatchSet::apply(CodePatch* patch) {
+    operations.push_back({patch, true});
+}
+
+void PatchSet::revert(CodePatch* patch) {
+    operations.push_back({patch, false});
+}
+
+size_t PatchSet::size() {
+    return operations.size();
+}
+
+void PatchSet::commit() {
+    if (operations.empty()) return;
+
+    auto protection = get_memory_protection();
+    uintptr_t page_size = protection->page_size();
+
+    // Find every page we're going to write to. Patches can cross pages.
+    std::map<uintptr_t, uint32_t> pages;
+    for (auto &operation : operations) {
+        auto patch = operation.patch;
+        if (operation.apply) assert(patch->patch_built);
+        if (!patch->patch_built) continue;
+
+        uintptr_t first_page = patch->patch_address & ~(page_size - 1);
+        uintptr_t last_page = (patch->patch_address + patch->patch_size - 1)
+                            & ~(page_size - 1);
+        for (uintptr_t page = first_page; page <= last_page; page += page_size) {
+            pages[page] = 0;
+        }
+    }
+
+    // Each page gets its own call, so each page gets back exactly the
+    // protection it had.
+    for (auto &page : pages) {
+        protection->make_writable(page.first, page_size, &page.second);
+    }
+
+    for (auto &operation : operations) {
+        auto patch = operation.patch;
+        if (operation.apply) {
+            printf("Apply CodePatch %s\n", patch->name);
+            patch->write_bytes(patch->patched_code);
+            patch->patch_applied = true;
+            printf("Applied.\n");
+        } else {
+            printf("Revert CodePatch %s", patch->name);
+            if (patch->patch_applied) {
+                patch->write_bytes(patch->original_code);
+                printf("Reverted.\n");
+            } else {
+                printf("No need.\n");
+            }
+            patch->patch_applied = false;
+        }
+    }
+
+    for (auto &page : pages) {
+        protection->restore(page.first, page_size, page.second);
+    }
+
+    operations.clear();
+}
+
+static PatchSet* open_set = NULL;
+
+void open_patch_set(PatchSet* set) {
+    open_set = set;
+}
+
+void close_patch_set() {
+    open_set = NULL;
+}
+
+PatchSet* get_open_patch_set() {
+    return open_set;
+}
@@ -0,0 +1,57 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "hooker.hpp"
+
+// Applies and reverts a bunch of CodePatches in one go.
+//
+// Changing memory protection is slow compared to writing a few bytes, and
+// lots of patches end up on the same pages. A PatchSet makes every page it
+// touches writable once, writes all of the patches in the order they were
+// queued, and then restores the protection of every page.
+class PatchSet {
+public:
+    // Queue a patch to be applied or reverted when the set is committed.
+    void apply(CodePatch* patch);
+    void revert(CodePatch* patch);
+
+    // Does everything that was queued and empties the queue.
+    void commit();
+
+    // Returns the amount of queued patches.
+    size_t size();
+private:
+    struct Operation {
+        CodePatch* patch;
+        bool apply;
+    };
+    std::vector<Operation> operations;
+};
+
+// While a set is open CodePatch::apply() and revert() queue themselves in it
+// instead of writing right away. Use this to batch up patches made by code
+// that doesn't know about PatchSets, then commit the set when done.
+// Anything else that writes to code, like set_call_address, still writes
+// right away and doesn't wait for the set.
+void open_patch_set(PatchSet* set);
+void close_patch_set();
+PatchSet* get_open_patch_set();
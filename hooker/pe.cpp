@@ -0,0 +1,172 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cstring>
+
+#include "pe.hpp"
+
+// Only the parts of the headers we need. Everything is little endian,
+// which is fine as long as we only ever run on x86.
+
+static const uint16_t DOS_MAGIC = 0x5A4D;     // "MZ"
+static const uint32_t PE_MAGIC  = 0x00004550; // "PE\0\0"
+// Where the DOS header keeps the offset of the PE header.
+static const size_t DOS_PE_HEADER_OFFSET = 0x3C;
+// Where the optional header keeps the size of the loaded image. It's at the
+// same place for 32 and 64 bit images.
+static const size_t OPTIONAL_IMAGE_SIZE_OFFSET = 56;
+
+struct PeFileHeader {
+    uint16_t machine;
+    uint16_t section_count;
+    uint32_t timestamp;
+    uint32_t symbol_table_offset;
+    uint32_t symbol_count;
+    uint16_t optional_header_size;
+    uint16_t flags;
+};
+static_assert(sizeof(PeFileHeader) == 20);
+
+struct PeSectionHeader {
+    char name[8];
+    uint32_t virtual_size;
+    uint32_t virtual_address;
+    uint32_t raw_size;
+    uint32_t raw_offset;
+    uint32_t relocations_offset;
+    uint32_t line_numbers_offset;
+    uint16_t relocation_count;
+    uint16_t line_number_count;
+    uint32_t flags;
+};
+static_assert(sizeof(PeSectionHeader) == 40);
+
+uint32_t PeSection::size() const {
+    return virtual_size ? virtual_size : raw_size;
+}
+
+// Copies a header out of the image if it is fully inside of it.
+// We copy instead of casting because nothing guarantees alignment.
+static bool read_at(const uint8_t* image, size_t size, size_t offset,
+                    void* out, size_t out_size) {
+    if (offset > size || out_size > size - offset) return false;
+    memcpy(out, image + offset, out_size);
+    return true;
+}
+
+// Finds the file header, which is where everything else hangs off of.
+static bool read_file_header(const uint8_t* image, size_t size,
+                             size_t* file_header_offset, PeFileHeader* file_header) {
+    uint16_t dos_magic;
+    uint32_t pe_header_offset;
+    if (!read_at(image, size, 0, &dos_magic, sizeof(dos_magic))
+    || dos_magic != DOS_MAGIC
+    || !read_at(image, size, DOS_PE_HEADER_OFFSET,
+                &pe_header_offset, sizeof(pe_header_offset))) {
+        return false;
+    }
+
+    uint32_t pe_magic;
+    if (!read_at(image, size, pe_header_offset, &pe_magic, sizeof(pe_magic))
+    || pe_magic != PE_MAGIC) {
+        return false;
+    }
+    *file_header_offset = static_cast<size_t>(pe_header_offset) + sizeof(pe_magic);
+    return read_at(image, size, *file_header_offset,
+                   file_header, sizeof(*file_header));
+}
+
+bool pe_read_sections(const uint8_t* image, size_t size,
+                      std::vector<PeSection>* sections) {
+    sections->clear();
+
+    size_t file_header_offset;
+    PeFileHeader file_header;
+    if (!read_file_header(image, size, &file_header_offset, &file_header)) {
+        return false;
+    }
+
+    // The section table comes right after the optional header.
+    size_t table_offset = file_header_offset + sizeof(file_header)
+                        + file_header.optional_header_size;
+    for (size_t i = 0; i < file_header.section_count; i++) {
+        PeSectionHeader header;
+        if (!read_at(image, size, table_offset + i * sizeof(header),
+                     &header, sizeof(header))) {
+            sections->clear();
+            return false;
+        }
+        PeSection section;
+        memcpy(section.name, header.name, sizeof(header.name));
+        section.name[8] = '\0';
+        section.virtual_address = header.virtual_address;
+        section.virtual_size = header.virtual_size;
+        section.raw_offset = header.raw_offset;
+        section.raw_size = header.raw_size;
+        section.flags = header.flags;
+        sections->push_back(section);
+    }
+    return true;
+}
+
+bool pe_read_image_size(const uint8_t* image, size_t size,
+                        uint32_t* image_size) {
+    size_t file_header_offset;
+    PeFileHeader file_header;
+    if (!read_file_header(image, size, &file_header_offset, &file_header)
+    || file_header.optional_header_size < OPTIONAL_IMAGE_SIZE_OFFSET + sizeof(*image_size)) {
+        return false;
+    }
+    size_t optional_header_offset = file_header_offset + sizeof(file_header);
+    return read_at(image, size, optional_header_offset + OPTIONAL_IMAGE_SIZE_OFFSET,
+                   image_size, sizeof(*image_size));
+}
+
+const PeSection* pe_find_section(const std::vector<PeSection>& sections,
+                                 const char* name) {
+    for (auto &section : sections) {
+        if (strcmp(section.name, name) == 0) return &section;
+    }
+    return NULL;
+}
+
+static uintptr_t executable_base = 0;
+static uint32_t executable_size = 0;
+static std::vector<PeSection> executable_sections;
+
+void set_executable_sections(uintptr_t image_base, uint32_t image_size,
+                             std::vector<PeSection> sections) {
+    executable_base = image_base;
+    executable_size = image_size;
+    executable_sections = sections;
+}
+
+bool get_executable_image(uintptr_t* start_address, uintptr_t* end_address) {
+    if (!executable_size) return false;
+    *start_address = executable_base;
+    *end_address = executable_base + executable_size;
+    return true;
+}
+
+bool get_executable_section(const char* name,
+                            uintptr_t* start_address, uintptr_t* end_address) {
+    auto section = pe_find_section(executable_sections, name);
+    if (!section) return false;
+    *start_address = executable_base + section->virtual_address;
+    *end_address = *start_address + section->size();
+    return true;
+}
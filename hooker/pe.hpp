@@ -0,0 +1,77 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A small reader for the headers of PE images (.exe and .dll files).
+// It doesn't depend on windows.h so it works on any platform, both on images
+// loaded into memory and on files read into a buffer.
+
+enum PeSectionFlags : uint32_t {
+    PE_SECTION_CODE         = 0x00000020,
+    PE_SECTION_INITIALIZED  = 0x00000040,
+    PE_SECTION_EXECUTE      = 0x20000000,
+    PE_SECTION_READ         = 0x40000000,
+    PE_SECTION_WRITE        = 0x80000000
+};
+
+struct PeSection {
+    // Section names are at most 8 characters, this one is always terminated.
+    char name[9];
+    // Where the section is relative to the start of the loaded image.
+    uint32_t virtual_address;
+    uint32_t virtual_size;
+    // Where the section is in the file.
+    uint32_t raw_offset;
+    uint32_t raw_size;
+    uint32_t flags;
+
+    // Size of the section once loaded. Some linkers leave the virtual size
+    // at 0, in which case the raw size is all we have.
+    uint32_t size() const;
+};
+
+// Reads the section table from the headers at the start of an image.
+// size is how many bytes can safely be read from the image.
+// Returns false if this doesn't look like a valid PE image.
+bool pe_read_sections(const uint8_t* image, size_t size,
+                      std::vector<PeSection>* sections);
+
+// Reads how many bytes the image takes up once loaded (SizeOfImage).
+// Returns false if this doesn't look like a valid PE image.
+bool pe_read_image_size(const uint8_t* image, size_t size,
+                        uint32_t* image_size);
+
+// Returns the first section with this name, or NULL if there isn't one.
+const PeSection* pe_find_section(const std::vector<PeSection>& sections,
+                                 const char* name);
+
+// The sections of the executable we're hooking, so signatures can be limited
+// to a single one of them. Set once on initialization.
+void set_executable_sections(uintptr_t image_base, uint32_t image_size,
+                             std::vector<PeSection> sections);
+// Gets the address range the whole executable is loaded at.
+// Returns false if it was never set.
+bool get_executable_image(uintptr_t* start_address, uintptr_t* end_address);
+// Gets the address range a section of the executable is loaded at.
+// Returns false if the executable doesn't have this section.
+bool get_executable_section(const char* name,
+                            uintptr_t* start_address, uintptr_t* end_address);
@@ -0,0 +1,183 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cstdio>
+#include <util/crc32.hpp>
+
+#include "signature_cache.hpp"
+
+// Bump this if the layout of the file changes.
+static const uint32_t CACHE_FILE_VERSION = 2;
+
+// The file is plain text so it can be inspected by hand:
+//
+// vulpes_signature_cache <version> <fingerprint>
+// <signature name> <key> <address count> <address> <address> ...
+
+SignatureCache::SignatureCache(std::string file_path, uint32_t code_fingerprint) {
+    path = file_path;
+    fingerprint = code_fingerprint;
+}
+
+void SignatureCache::load() {
+    results.clear();
+    changed = false;
+
+    FILE* file = fopen(path.data(), "r");
+    if (!file) return;
+
+    uint32_t version;
+    uint32_t file_fingerprint;
+    if (fscanf(file, "vulpes_signature_cache %u %X",
+               &version, &file_fingerprint) != 2
+    || version != CACHE_FILE_VERSION
+    || file_fingerprint != fingerprint) {
+        printf("Signature cache is outdated, rescanning.\n");
+        fclose(file);
+        return;
+    }
+
+    char name[128];
+    uint32_t key;
+    uint32_t count;
+    while (fscanf(file, "%127s %X %u", name, &key, &count) == 3) {
+        std::vector<uintptr_t> addresses;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t address;
+            if (fscanf(file, "%X", &address) != 1) break;
+            addresses.push_back(address);
+        }
+        // A cut off entry is useless, we'll just search for it again.
+        if (addresses.size() == count) {
+            results[name] = {key, addresses};
+        }
+    }
+    fclose(file);
+}
+
+void SignatureCache::save() {
+    if (!changed) return;
+
+    FILE* file = fopen(path.data(), "w");
+    if (!file) {
+        printf("Couldn't write signature cache to %s\n", path.data());
+        return;
+    }
+    fprintf(file, "vulpes_signature_cache %u %08X\n",
+            CACHE_FILE_VERSION, fingerprint);
+    for (auto &entry : results) {
+        fprintf(file, "%s %08X %u", entry.first.data(),
+                entry.second.key, entry.second.addresses.size());
+        for (auto address : entry.second.addresses) {
+            fprintf(file, " %08X", address);
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    changed = false;
+}
+
+// Signatures with the same name can change between versions of Vulpes, so
+// results are only valid for the exact bytes and range they were found with.
+static uint32_t result_key(LiteSignature* signature,
+                           uintptr_t start_address, uintptr_t end_address) {
+    uint32_t key = crc32(0, signature->values, signature->size);
+    key = crc32(key, signature->masks, signature->size);
+    key = crc32(key, &start_address, sizeof(start_address));
+    return crc32(key, &end_address, sizeof(end_address));
+}
+
+// Checks if a cached address can still be trusted.
+static bool still_matches(LiteSignature* signature, uintptr_t address,
+                          uintptr_t start_address, uintptr_t end_address) {
+    return address >= start_address
+        && address + signature->size <= end_address
+        && signature->matches(address);
+}
+
+bool SignatureCache::lookup(LiteSignature* signature, uintptr_t* result,
+                            uintptr_t start_address, uintptr_t end_address) {
+    auto entry = results.find(signature->name);
+    if (entry == results.end()
+    || entry->second.key != result_key(signature, start_address, end_address)
+    || entry->second.addresses.size() != 1) {
+        return false;
+    }
+    auto &addresses = entry->second.addresses;
+
+    if (!still_matches(signature, addresses[0], start_address, end_address)) {
+        return false;
+    }
+
+    *result = addresses[0];
+    return true;
+}
+
+bool SignatureCache::lookup_multiple(LiteSignature* signature,
+                                     std::vector<uintptr_t>* addresses,
+                                     uintptr_t start_address,
+                                     uintptr_t end_address) {
+    auto entry = results.find(signature->name);
+    if (entry == results.end()
+    || entry->second.key != result_key(signature, start_address, end_address)
+    || entry->second.addresses.empty()) {
+        return false;
+    }
+
+    for (auto address : entry->second.addresses) {
+        if (!still_matches(signature, address, start_address, end_address)) {
+            return false;
+        }
+    }
+
+    *addresses = entry->second.addresses;
+    return true;
+}
+
+void SignatureCache::store(LiteSignature* signature, uintptr_t result,
+                           uintptr_t start_address, uintptr_t end_address) {
+    std::vector<uintptr_t> addresses;
+    if (result) addresses.push_back(result);
+    store_multiple(signature, addresses, start_address, end_address);
+}
+
+void SignatureCache::store_multiple(LiteSignature* signature,
+                                    std::vector<uintptr_t> addresses,
+                                    uintptr_t start_address,
+                                    uintptr_t end_address) {
+    // Misses get searched for again every time, see the header.
+    if (addresses.empty()) {
+        if (results.erase(signature->name)) changed = true;
+        return;
+    }
+    uint32_t key = result_key(signature, start_address, end_address);
+    auto &entry = results[signature->name];
+    if (entry.key != key || entry.addresses != addresses) {
+        entry = {key, addresses};
+        changed = true;
+    }
+}
+
+static SignatureCache* signature_cache = NULL;
+
+SignatureCache* get_signature_cache() {
+    return signature_cache;
+}
+
+void set_signature_cache(SignatureCache* cache) {
+    signature_cache = cache;
+}
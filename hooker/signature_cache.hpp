@@ -0,0 +1,71 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "hooker.hpp"
+
+// Remembers where signatures were found so the next launch of the same
+// executable doesn't need to scan for them again.
+//
+// The file is tied to a fingerprint of the code it was made for. If the
+// fingerprint doesn't match we start over with an empty cache.
+class SignatureCache {
+public:
+    SignatureCache(std::string file_path, uint32_t code_fingerprint);
+
+    // Loads results from the cache file if it was made for this fingerprint.
+    void load();
+    // Writes the cache file, but only if any results changed since loading.
+    void save();
+
+    // Returns true if a result for this signature was cached and it still
+    // matches the bytes in memory. The result is written to the output.
+    // The range is where the signature would be searched in. Results from
+    // a different range or an older version of the signature are ignored.
+    bool lookup(LiteSignature* signature, uintptr_t* result,
+                uintptr_t start_address, uintptr_t end_address);
+    bool lookup_multiple(LiteSignature* signature, std::vector<uintptr_t>* addresses,
+                         uintptr_t start_address, uintptr_t end_address);
+
+    // Saves the result of a search. NULL and empty results are not saved.
+    // The fingerprint only covers the code, so something that isn't there
+    // now can show up later, like in a data section or after patching.
+    void store(LiteSignature* signature, uintptr_t result,
+               uintptr_t start_address, uintptr_t end_address);
+    void store_multiple(LiteSignature* signature, std::vector<uintptr_t> addresses,
+                        uintptr_t start_address, uintptr_t end_address);
+private:
+    std::string path;
+    uint32_t fingerprint;
+    bool changed = false;
+    struct Result {
+        // Fingerprint of the signature bytes and the searched range.
+        uint32_t key;
+        std::vector<uintptr_t> addresses;
+    };
+    std::map<std::string, Result> results;
+};
+
+// The cache signature searches should use. NULL if there isn't one.
+SignatureCache* get_signature_cache();
+void set_signature_cache(SignatureCache* cache);
@@ -0,0 +1,125 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include "signature_match.hpp"
+
+SignatureMatcher::SignatureMatcher(uintptr_t start_address, uintptr_t end_address) {
+    this->start_address = start_address;
+    this->end_address = end_address;
+}
+
+size_t SignatureMatcher::add(LiteSignature* signature, bool single) {
+    signatures.push_back(signature);
+    this->single.push_back(single);
+    return signatures.size() - 1;
+}
+
+void SignatureMatcher::prepare(uintptr_t chunk_size) {
+    // Flatten the buckets into one array so the hot loop stays in cache.
+    for (auto sig : signatures) {
+        bucket_start[sig->values[sig->anchor] + 1]++;
+        if (sig->anchor > max_anchor) max_anchor = sig->anchor;
+    }
+    for (size_t b = 0; b < 256; b++) {
+        bucket_start[b + 1] += bucket_start[b];
+    }
+    bucket_entries.resize(bucket_start[256]);
+    size_t bucket_fill[256];
+    for (size_t b = 0; b < 256; b++) {
+        bucket_fill[b] = bucket_start[b];
+    }
+    for (size_t i = 0; i < signatures.size(); i++) {
+        auto b = signatures[i]->values[signatures[i]->anchor];
+        bucket_entries[bucket_fill[b]++] = i;
+    }
+
+    uintptr_t range = end_address > start_address ? end_address - start_address : 0;
+    if (chunk_size == 0 || chunk_size > range) chunk_size = range;
+    this->chunk_size = chunk_size;
+    chunks = chunk_size ? (range + chunk_size - 1) / chunk_size : 0;
+    chunk_hits.resize(chunks);
+    for (auto &hits : chunk_hits) {
+        hits.resize(signatures.size());
+    }
+}
+
+size_t SignatureMatcher::chunk_count() {
+    return chunks;
+}
+
+void SignatureMatcher::scan_chunk(size_t chunk_id) {
+    uintptr_t chunk_start = start_address + chunk_id * chunk_size;
+    uintptr_t chunk_end = chunk_start + chunk_size;
+    if (chunk_end > end_address) chunk_end = end_address;
+    // Walk a little past the chunk, so we see the anchors of signatures that
+    // start at the end of it. Those that start in the next chunk are skipped.
+    uintptr_t walk_end = chunk_end + max_anchor;
+    if (walk_end > end_address) walk_end = end_address;
+
+    auto &hits = chunk_hits[chunk_id];
+
+    size_t single_remaining = 0;
+    bool has_multiple = false;
+    for (size_t i = 0; i < signatures.size(); i++) {
+        if (single[i]) single_remaining++;
+        else           has_multiple = true;
+    }
+
+    // We walk over every address once. The signatures in the bucket of the
+    // byte at that address get checked as if they started anchor bytes back.
+    // Because we walk upwards every signature sees its candidates in
+    // ascending order, so the first hit is the same one search() would find.
+    bool searching = true;
+    for (uintptr_t address = chunk_start; searching && address < walk_end; address++) {
+        auto b = *reinterpret_cast<const uint8_t*>(address);
+        size_t first = bucket_start[b];
+        size_t last  = bucket_start[b + 1];
+        for (size_t i = first; i < last; i++) {
+            size_t id = bucket_entries[i];
+            if (single[id] && !hits[id].empty()) continue;
+
+            auto sig = signatures[id];
+            if (address - chunk_start < sig->anchor) continue;
+            uintptr_t candidate = address - sig->anchor;
+            if (candidate >= chunk_end) continue;
+            if (candidate + sig->size > end_address) continue;
+            if (!sig->matches(candidate)) continue;
+
+            hits[id].push_back(candidate);
+            if (single[id]) single_remaining--;
+        }
+        // Multi signatures need the whole range, singles can stop early.
+        searching = single_remaining || has_multiple;
+    }
+}
+
+// A single result comes from the first chunk that found it, multi results
+// are just appended in chunk order.
+uintptr_t SignatureMatcher::result(size_t index) {
+    for (auto &hits : chunk_hits) {
+        if (!hits[index].empty()) return hits[index][0];
+    }
+    return 0;
+}
+
+std::vector<uintptr_t> SignatureMatcher::results(size_t index) {
+    std::vector<uintptr_t> all;
+    for (auto &hits : chunk_hits) {
+        all.insert(all.end(), hits[index].begin(), hits[index].end());
+    }
+    return all;
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "hooker.hpp"
+
+// The part of SignatureScanner that looks at memory, a single pass over a
+// range for a whole batch of signatures. It knows nothing about threads, the
+// signature cache or where to search, so it can run anywhere.
+//
+// Every signature is put into a bucket keyed by its anchor byte. While walking
+// the range we only look at the bucket of the byte we're currently at, so most
+// addresses cost a single table lookup no matter how many signatures there are.
+//
+// The range is split into chunks that can be scanned in any order and from
+// any thread, as long as every chunk is scanned by only one of them. The
+// results are put back together as if the whole range was walked in one go.
+class SignatureMatcher {
+public:
+    SignatureMatcher(uintptr_t start_address, uintptr_t end_address);
+
+    // Adds a signature. Single signatures only need their first match,
+    // others need all of them. Returns the index to get its results with.
+    size_t add(LiteSignature* signature, bool single);
+
+    // Call after adding everything and before scanning.
+    // A chunk_size of 0 makes the whole range one chunk.
+    void prepare(uintptr_t chunk_size = 0);
+    size_t chunk_count();
+
+    void scan_chunk(size_t chunk_id);
+
+    // Once every chunk was scanned. The first match, or 0 if there is none.
+    uintptr_t result(size_t index);
+    // All matches in ascending order.
+    std::vector<uintptr_t> results(size_t index);
+private:
+    uintptr_t start_address;
+    uintptr_t end_address;
+    uintptr_t chunk_size = 0;
+    size_t chunks = 0;
+
+    std::vector<LiteSignature*> signatures;
+    std::vector<bool> single;
+
+    // Bucket b lives at bucket_entries[bucket_start[b]..bucket_start[b+1]].
+    size_t bucket_start[257] = {};
+    std::vector<size_t> bucket_entries;
+    // How far past its chunk a chunk needs to be walked to see the anchor of
+    // every signature that starts inside of it.
+    size_t max_anchor = 0;
+
+    // chunk_hits[chunk][signature] holds the hits of a signature that start
+    // inside of that chunk.
+    std::vector<std::vector<std::vector<uintptr_t>>> chunk_hits;
+};
@@ -0,0 +1,331 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <util/threads.hpp>
+
+#include "pe.hpp"
+#include "signature_cache.hpp"
+#include "signature_match.hpp"
+#include "signature_scanner.hpp"
+
+// Chunks are never smaller than this, splitting any smaller is pointless.
+static const uintptr_t MIN_CHUNK_SIZE = 0x10000;
+static const size_t CHUNKS_PER_THREAD = 4;
+
+// Shared by every thread taking part in a scan.
+//
+// We're usually called from DllMain, where new threads can't start running
+// until the loader lock is released. So the calling thread takes chunks from
+// the same queue as the workers and only ever waits for chunks that a worker
+// actually started on. If no worker gets to run, the caller does all of the
+// work itself. Workers that start late just find the queue empty, which is
+// why this is reference counted instead of living on the caller's stack.
+struct ScanJob : std::enable_shared_from_this<ScanJob> {
+    SignatureMatcher matcher;
+    size_t chunk_count = 0;
+
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> chunks_done{0};
+
+    ScanJob(uintptr_t start_address, uintptr_t end_address)
+        : matcher(start_address, end_address) {}
+
+    void take_chunks();
+    void run(size_t thread_count);
+};
+
+void ScanJob::take_chunks() {
+    size_t chunk_id;
+    while ((chunk_id = next_chunk++) < chunk_count) {
+        matcher.scan_chunk(chunk_id);
+        chunks_done++;
+    }
+}
+
+static void scan_worker(void* param) {
+    auto job = reinterpret_cast<std::shared_ptr<ScanJob>*>(param);
+    (*job)->take_chunks();
+    delete job;
+}
+
+void ScanJob::run(size_t thread_count) {
+    if (thread_count > chunk_count) thread_count = chunk_count;
+    // The calling thread counts as one.
+    for (size_t i = 1; i < thread_count; i++) {
+        auto job_ref = new std::shared_ptr<ScanJob>(shared_from_this());
+        if (!start_thread(scan_worker, job_ref)) {
+            delete job_ref;
+        }
+    }
+    take_chunks();
+    // Only chunks a worker is busy with can be left at this point.
+    while (chunks_done < chunk_count) {
+        yield_thread();
+    }
+}
+
+static size_t signature_scan_threads = 0;
+
+void set_signature_scan_threads(size_t count) {
+    signature_scan_threads = count;
+}
+
+size_t get_signature_scan_threads() {
+    if (signature_scan_threads) return signature_scan_threads;
+    return processor_count();
+}
+
+void SignatureScanner::add(LiteSignature* signature, uintptr_t* result,
+                           SignatureRegion region) {
+    entries.push_back({signature, result, NULL, region, 0, 0, false, false, false});
+}
+
+void SignatureScanner::add_multiple(LiteSignature* signature,
+                                    std::vector<uintptr_t>* results,
+                                    SignatureRegion region) {
+    entries.push_back({signature, NULL, results, region, 0, 0, false, false, false});
+}
+
+size_t SignatureScanner::size() {
+    return entries.size();
+}
+
+// A signature that should be near another one can only be searched for once
+// we know where that one is.
+bool SignatureScanner::ready(Entry& entry) {
+    if (!entry.region.near) return true;
+    for (auto &other : entries) {
+        if (other.result == entry.region.near) return other.done;
+    }
+    // It isn't one of ours, so it was already found before this scan.
+    return true;
+}
+
+// Shrinks a range so it only covers what is also inside of the limit.
+static void limit_range(uintptr_t* start_address, uintptr_t* end_address,
+                        uintptr_t limit_start, uintptr_t limit_end) {
+    if (limit_start > *start_address) *start_address = limit_start;
+    if (limit_end < *end_address) *end_address = limit_end;
+}
+
+// Works out where to search for a signature. Signatures without hints just
+// use the given range. Returns false if there is nowhere to search.
+bool SignatureScanner::resolve_region(Entry& entry,
+        uintptr_t start_address, uintptr_t end_address) {
+    auto &region = entry.region;
+    bool has_window = region.start_address && region.end_address;
+
+    // Hints can point outside of the code, so they replace the default range
+    // instead of narrowing it down.
+    if (region.section || has_window || region.near) {
+        start_address = 0;
+        end_address = UINTPTR_MAX;
+    }
+
+    if (region.section) {
+        uintptr_t section_start;
+        uintptr_t section_end;
+        if (!get_executable_section(region.section, &section_start, &section_end)) {
+            printf("Sig %s can't be searched for, the executable has no %s section.\n",
+                entry.signature->name, region.section);
+            return false;
+        }
+        limit_range(&start_address, &end_address, section_start, section_end);
+    }
+    if (has_window) {
+        limit_range(&start_address, &end_address,
+                    region.start_address, region.end_address);
+    }
+    if (region.near) {
+        uintptr_t near_address = *region.near;
+        if (!near_address) return false;
+        uintptr_t near_start = near_address > region.near_distance
+                             ? near_address - region.near_distance : 0;
+        uintptr_t near_end = UINTPTR_MAX - near_address > region.near_distance
+                           ? near_address + region.near_distance : UINTPTR_MAX;
+        limit_range(&start_address, &end_address, near_start, near_end);
+    }
+
+    // Whatever the hints say, never read outside of the executable. A wide
+    // window or near distance would otherwise run into unmapped memory.
+    uintptr_t image_start;
+    uintptr_t image_end;
+    if ((region.section || has_window || region.near)
+    && get_executable_image(&image_start, &image_end)) {
+        limit_range(&start_address, &end_address, image_start, image_end);
+    }
+
+    entry.start_address = start_address;
+    entry.end_address = end_address;
+    return start_address < end_address;
+}
+
+// Searches for a group of signatures that all share the same range.
+void SignatureScanner::search(std::vector<Entry*> group) {
+    uintptr_t start_address = group[0]->start_address;
+    uintptr_t end_address = group[0]->end_address;
+
+    // Everything the threads need to know about what we're looking for.
+    auto job = std::make_shared<ScanJob>(start_address, end_address);
+    for (auto entry : group) {
+        job->matcher.add(entry->signature, entry->result != NULL);
+    }
+
+    // Split the range into chunks, a few per thread so that a thread that
+    // gets a slow chunk doesn't hold everyone else up.
+    size_t thread_count = get_signature_scan_threads();
+    uintptr_t range = end_address - start_address;
+    uintptr_t chunk_size = range / (thread_count * CHUNKS_PER_THREAD) + 1;
+    if (chunk_size < MIN_CHUNK_SIZE) chunk_size = MIN_CHUNK_SIZE;
+    job->matcher.prepare(chunk_size);
+    job->chunk_count = job->matcher.chunk_count();
+
+    job->run(thread_count);
+
+    for (size_t i = 0; i < group.size(); i++) {
+        auto entry = group[i];
+        if (entry->result) {
+            *entry->result = job->matcher.result(i);
+            entry->found = *entry->result != 0;
+        } else {
+            *entry->results = job->matcher.results(i);
+            entry->found = !entry->results->empty();
+        }
+    }
+}
+
+void SignatureScanner::scan(uintptr_t start_address, uintptr_t end_address) {
+    if (!start_address) start_address = get_lowest_permitted_address();
+    if (!end_address) end_address = get_highest_permitted_address();
+
+    if (!signature_search_quiet()) {
+        printf("Scanning for %d signatures\nAddress range: %8X - %8X\n",
+            entries.size(), start_address, end_address);
+    }
+
+    // Reset the outputs so that anything we don't find ends up as NULL.
+    for (auto &entry : entries) {
+        entry.found = false;
+        entry.cached = false;
+        entry.done = false;
+        if (entry.result)  *entry.result = 0;
+        if (entry.results) entry.results->clear();
+    }
+
+    auto cache = get_signature_cache();
+
+    // Each round searches for everything that doesn't depend on a signature
+    // that hasn't been found yet. Usually that is all of them in one go.
+    bool progress = true;
+    while (progress) {
+        std::vector<Entry*> round;
+        for (auto &entry : entries) {
+            if (!entry.done && ready(entry)) round.push_back(&entry);
+        }
+        progress = !round.empty();
+
+        // Signatures that share a range are searched for together.
+        std::map<std::pair<uintptr_t, uintptr_t>, std::vector<Entry*>> groups;
+        for (auto entry : round) {
+            entry->done = true;
+            if (!resolve_region(*entry, start_address, end_address)) continue;
+
+            // Anything we already know the location of doesn't need to be searched.
+            if (cache && entry->result) {
+                entry->cached = cache->lookup(entry->signature, entry->result,
+                    entry->start_address, entry->end_address);
+                entry->found = entry->cached && *entry->result;
+            } else if (cache) {
+                entry->cached = cache->lookup_multiple(entry->signature, entry->results,
+                    entry->start_address, entry->end_address);
+                entry->found = entry->cached && !entry->results->empty();
+            }
+            if (entry->cached) continue;
+
+            groups[{entry->start_address, entry->end_address}].push_back(entry);
+        }
+
+        for (auto &group : groups) {
+            search(group.second);
+            if (!cache) continue;
+            for (auto entry : group.second) {
+                if (entry->result) {
+                    cache->store(entry->signature, *entry->result,
+                        entry->start_address, entry->end_address);
+                } else {
+                    cache->store_multiple(entry->signature, *entry->results,
+                        entry->start_address, entry->end_address);
+                }
+            }
+        }
+    }
+
+    if (cache) cache->save();
+
+    report();
+}
+
+void resolve_lazy_signature(LiteSignature* signature, uintptr_t* result,
+                            bool* resolved, SignatureRegion region) {
+    if (*resolved) return;
+    SignatureScanner scanner;
+    scanner.add(signature, result, region);
+    scanner.scan();
+    *resolved = true;
+    if (!*result) {
+        printf("Vulpes cannot find the non-crucial signature %s\n",
+            signature->name);
+    }
+}
+
+void resolve_lazy_signature_multiple(LiteSignature* signature,
+                                     std::vector<uintptr_t>* results,
+                                     bool* resolved, SignatureRegion region) {
+    if (*resolved) return;
+    SignatureScanner scanner;
+    scanner.add_multiple(signature, results, region);
+    scanner.scan();
+    *resolved = true;
+    if (results->empty()) {
+        printf("Vulpes cannot find the non-crucial signature %s\n",
+            signature->name);
+    }
+}
+
+void SignatureScanner::report() {
+    if (signature_search_quiet()) return;
+    for (auto &entry : entries) {
+        if (entry.result) {
+            if (entry.found) {
+                printf("Sig %s found at: %8X%s\n",
+                    entry.signature->name, *entry.result,
+                    entry.cached ? " (cached)" : "");
+            } else {
+                printf("Sig %s not found.\n", entry.signature->name);
+            }
+        } else {
+            printf("Multi sig %s found %d addresses.%s\n",
+                entry.signature->name, entry.results->size(),
+                entry.cached ? " (cached)" : "");
+        }
+    }
+    printf("\n");
+}
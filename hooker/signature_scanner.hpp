@@ -0,0 +1,112 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "hooker.hpp"
+
+// Narrows down where a signature is searched for. Everything left at its
+// default means the whole permitted address range. If more than one hint is
+// given only the part that satisfies all of them is searched.
+//
+// Hints don't have to be inside of the code, so they make it possible to
+// find things in the data sections too. They are always kept inside of the
+// executable's image though.
+struct SignatureRegion {
+    // Name of the executable section to search in, like ".rdata".
+    const char* section = NULL;
+    // Address window to search in. Needs both ends to be used.
+    uintptr_t start_address = 0;
+    uintptr_t end_address = 0;
+    // Result of another signature. If set we only search within
+    // near_distance bytes of wherever that signature was found.
+    const uintptr_t* near = NULL;
+    uintptr_t near_distance = 0;
+};
+
+// Finds a whole batch of signatures in a single pass over memory.
+//
+// Every queued signature is put into a bucket keyed by its anchor byte.
+// While walking the range we only look at the bucket of the byte we're
+// currently at, so most addresses cost a single table lookup no matter how
+// many signatures are queued.
+//
+// The range is split into chunks which are spread over a few threads. The
+// results are merged so they are exactly what a single thread would find.
+//
+// Signatures with a region are grouped with the ones that share it, each
+// group gets its own pass over only its own region.
+class SignatureScanner {
+public:
+    // Queue a signature. Its first match will be written to result.
+    void add(LiteSignature* signature, uintptr_t* result,
+             SignatureRegion region = SignatureRegion());
+    // Queue a signature. All of its matches will be written to results,
+    // in ascending order, just like LiteSignature::search_multiple does.
+    void add_multiple(LiteSignature* signature, std::vector<uintptr_t>* results,
+                      SignatureRegion region = SignatureRegion());
+
+    // Searches for all queued signatures and writes their results.
+    // If no range is given the permitted address range is used for the
+    // signatures that don't have a region of their own.
+    // Signatures that aren't found get NULL or an empty vector.
+    // Signatures with a valid entry in the signature cache aren't searched
+    // for, and everything that was searched for is added to the cache.
+    void scan(uintptr_t start_address = 0, uintptr_t end_address = 0);
+
+    // Returns the amount of queued signatures.
+    size_t size();
+private:
+    struct Entry {
+        LiteSignature* signature;
+        uintptr_t* result;
+        std::vector<uintptr_t>* results;
+        SignatureRegion region;
+        // The range this signature ends up being searched in.
+        uintptr_t start_address;
+        uintptr_t end_address;
+        bool found;
+        bool cached;
+        bool done;
+    };
+    std::vector<Entry> entries;
+
+    bool ready(Entry& entry);
+    bool resolve_region(Entry& entry, uintptr_t start_address, uintptr_t end_address);
+    void search(std::vector<Entry*> group);
+    void report();
+};
+
+// Finds a signature that wasn't searched for on initialization, the first
+// time it is needed. Does nothing if resolved is already true, otherwise the
+// result is written and resolved is set so we never search twice.
+// Uses the signature cache just like SignatureScanner does.
+void resolve_lazy_signature(LiteSignature* signature, uintptr_t* result,
+                            bool* resolved,
+                            SignatureRegion region = SignatureRegion());
+void resolve_lazy_signature_multiple(LiteSignature* signature,
+                                     std::vector<uintptr_t>* results,
+                                     bool* resolved,
+                                     SignatureRegion region = SignatureRegion());
+
+// Sets how many threads (including the calling one) scans may use.
+// 0 means one per processor, which is the default.
+void set_signature_scan_threads(size_t count);
+size_t get_signature_scan_threads();
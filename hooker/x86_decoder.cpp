@@ -0,0 +1,287 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cstring>
+
+#include "x86_decoder.hpp"
+
+static bool is_prefix(uint8_t byte) {
+    switch (byte) {
+    case 0x26: case 0x2E: case 0x36: case 0x3E: case 0x64: case 0x65:
+    case 0x66: case 0x67: case 0xF0: case 0xF2: case 0xF3:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Size of the ModRM byte and everything that hangs off of it.
+static size_t modrm_size(const uint8_t* modrm, bool address_16) {
+    uint8_t mod = *modrm >> 6;
+    uint8_t rm = *modrm & 7;
+    if (mod == 3) return 1;
+
+    if (address_16) {
+        if (mod == 0) return rm == 6 ? 3 : 1;
+        return mod == 1 ? 2 : 3;
+    }
+
+    size_t size = 1;
+    if (rm == 4) {
+        size++;
+        // A SIB base of ebp without a displacement means a plain disp32.
+        if (mod == 0 && (modrm[1] & 7) == 5) return size + 4;
+    }
+    if (mod == 0) return rm == 5 ? size + 4 : size;
+    return mod == 1 ? size + 1 : size + 4;
+}
+
+static bool one_byte_has_modrm(uint8_t op) {
+    if (op < 0x40) return (op & 7) < 4;
+    switch (op) {
+    case 0x62: case 0x63: case 0x69: case 0x6B:
+    case 0xC0: case 0xC1: case 0xC4: case 0xC5: case 0xC6: case 0xC7:
+    case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+    case 0xF6: case 0xF7: case 0xFE: case 0xFF:
+        return true;
+    }
+    if (op >= 0x80 && op <= 0x8F) return true;
+    if (op >= 0xD8 && op <= 0xDF) return true;
+    return false;
+}
+
+// Immediate size of a one byte opcode, not counting the F6/F7 special case.
+static size_t one_byte_immediate(uint8_t op, bool operand_16, bool address_16) {
+    size_t full = operand_16 ? 2 : 4;
+    if (op < 0x40) {
+        if ((op & 7) == 4) return 1;
+        if ((op & 7) == 5) return full;
+        return 0;
+    }
+    if (op >= 0x70 && op <= 0x7F) return 1;
+    if (op >= 0xB0 && op <= 0xB7) return 1;
+    if (op >= 0xB8 && op <= 0xBF) return full;
+    if (op >= 0xE0 && op <= 0xE7) return 1;
+    if (op >= 0xA0 && op <= 0xA3) return address_16 ? 2 : 4;
+    switch (op) {
+    case 0x6A: case 0x6B: case 0x80: case 0x82: case 0x83: case 0xA8:
+    case 0xC0: case 0xC1: case 0xC6: case 0xCD: case 0xD4: case 0xD5:
+    case 0xEB:
+        return 1;
+    case 0x68: case 0x69: case 0x81: case 0xA9: case 0xC7:
+    case 0xE8: case 0xE9:
+        return full;
+    case 0xC2: case 0xCA:
+        return 2;
+    case 0xC8:
+        return 3;
+    case 0x9A: case 0xEA:
+        return full + 2;
+    }
+    return 0;
+}
+
+static bool two_byte_invalid(uint8_t op) {
+    switch (op) {
+    case 0x04: case 0x0A: case 0x0C: case 0x24: case 0x25: case 0x26:
+    case 0x27: case 0x36: case 0x39: case 0x3B: case 0x3C: case 0x3D:
+    case 0x3E: case 0x3F: case 0x7A: case 0x7B: case 0xA6: case 0xA7:
+        return true;
+    }
+    return false;
+}
+
+static bool two_byte_has_modrm(uint8_t op) {
+    switch (op) {
+    case 0x05: case 0x06: case 0x07: case 0x08: case 0x09: case 0x0B:
+    case 0x0E: case 0x77: case 0xA0: case 0xA1: case 0xA2: case 0xA8:
+    case 0xA9: case 0xAA:
+        return false;
+    }
+    if (op >= 0x30 && op <= 0x37) return false;
+    if (op >= 0x80 && op <= 0x8F) return false;
+    if (op >= 0xC8 && op <= 0xCF) return false;
+    return true;
+}
+
+static size_t two_byte_immediate(uint8_t op) {
+    switch (op) {
+    case 0x0F: // 3DNow! puts its real opcode where the immediate goes.
+    case 0x70: case 0x71: case 0x72: case 0x73:
+    case 0xA4: case 0xAC: case 0xBA: case 0xC2: case 0xC4: case 0xC5:
+    case 0xC6:
+        return 1;
+    }
+    return 0;
+}
+
+bool x86_decode(const uint8_t* code, X86Instruction* instruction) {
+    const uint8_t* start = code;
+    bool operand_16 = false;
+    bool address_16 = false;
+
+    // 15 bytes is the longest an instruction can be.
+    while (is_prefix(*code)) {
+        if (*code == 0x66) operand_16 = true;
+        if (*code == 0x67) address_16 = true;
+        code++;
+        if (code - start >= 15) return false;
+    }
+
+    instruction->opcode_offset = code - start;
+    instruction->branch = X86_NO_BRANCH;
+    instruction->branch_offset = 0;
+
+    uint8_t op = *code++;
+    size_t immediate = 0;
+    bool has_modrm;
+
+    if (op == 0x0F) {
+        op = *code++;
+        if (two_byte_invalid(op)) return false;
+        if (op == 0x38 || op == 0x3A) {
+            // Three byte opcodes always have a ModRM.
+            immediate = op == 0x3A ? 1 : 0;
+            code++;
+            has_modrm = true;
+        } else {
+            has_modrm = two_byte_has_modrm(op);
+            immediate = two_byte_immediate(op);
+        }
+        if (op >= 0x80 && op <= 0x8F) {
+            // jcc rel16 exists but nothing sane uses it.
+            if (operand_16) return false;
+            instruction->branch = X86_BRANCH_REL32;
+            immediate = 4;
+        }
+    } else {
+        has_modrm = one_byte_has_modrm(op);
+        immediate = one_byte_immediate(op, operand_16, address_16);
+        if ((op >= 0x70 && op <= 0x7F) || (op >= 0xE0 && op <= 0xE3) || op == 0xEB) {
+            // With 0x66 these cut eip down to 16 bits, and once made long
+            // they would turn into rel16 branches.
+            if (operand_16) return false;
+            instruction->branch = X86_BRANCH_REL8;
+        } else if (op == 0xE8 || op == 0xE9) {
+            if (operand_16) return false;
+            instruction->branch = X86_BRANCH_REL32;
+        } else if (op == 0xF6 || op == 0xF7) {
+            // Only test has an immediate in this group.
+            if (((*code >> 3) & 7) < 2) immediate = op == 0xF6 ? 1 : (operand_16 ? 2 : 4);
+        }
+    }
+
+    if (has_modrm) code += modrm_size(code, address_16);
+    if (instruction->branch != X86_NO_BRANCH) {
+        instruction->branch_offset = code - start;
+    }
+    code += immediate;
+
+    instruction->length = code - start;
+    return instruction->length <= 15;
+}
+
+uintptr_t x86_branch_target(uintptr_t address, const X86Instruction& instruction) {
+    const uint8_t* displacement = reinterpret_cast<const uint8_t*>(address)
+                                + instruction.branch_offset;
+    int32_t offset;
+    if (instruction.branch == X86_BRANCH_REL8) {
+        offset = static_cast<int8_t>(*displacement);
+    } else {
+        memcpy(&offset, displacement, 4);
+    }
+    return address + instruction.length + offset;
+}
+
+size_t x86_instructions_size(uintptr_t address, size_t min_size) {
+    size_t size = 0;
+    while (size < min_size) {
+        X86Instruction instruction;
+        if (!x86_decode(reinterpret_cast<const uint8_t*>(address + size), &instruction)) {
+            return 0;
+        }
+        size += instruction.length;
+    }
+    return size;
+}
+
+bool x86_find_return(uintptr_t address, size_t max_size, uint16_t* pop_size) {
+    size_t size = 0;
+    while (size < max_size) {
+        const uint8_t* code = reinterpret_cast<const uint8_t*>(address + size);
+        X86Instruction instruction;
+        if (!x86_decode(code, &instruction)) return false;
+        uint8_t op = code[instruction.opcode_offset];
+        if (op == 0xC3) {
+            *pop_size = 0;
+            return true;
+        }
+        if (op == 0xC2) {
+            memcpy(pop_size, code + instruction.opcode_offset + 1, 2);
+            return true;
+        }
+        size += instruction.length;
+    }
+    return false;
+}
+
+bool x86_relocate(uintptr_t address, size_t size, uintptr_t new_address,
+                  std::vector<uint8_t>* output) {
+    output->clear();
+    size_t position = 0;
+    while (position < size) {
+        uintptr_t current = address + position;
+        const uint8_t* code = reinterpret_cast<const uint8_t*>(current);
+        X86Instruction instruction;
+        if (!x86_decode(code, &instruction)) return false;
+
+        if (instruction.branch == X86_NO_BRANCH) {
+            output->insert(output->end(), code, code + instruction.length);
+            position += instruction.length;
+            continue;
+        }
+
+        uintptr_t target = x86_branch_target(current, instruction);
+        // The bytes at the target won't be there anymore once we're patched.
+        // That includes the first one, which is where our jump goes.
+        if (target >= address && target < address + size) return false;
+
+        // Keep prefixes like branch hints.
+        output->insert(output->end(), code, code + instruction.opcode_offset);
+        uint8_t op = code[instruction.opcode_offset];
+        if (instruction.branch == X86_BRANCH_REL8) {
+            if (op >= 0xE0 && op <= 0xE3) return false;
+            if (op == 0xEB) {
+                output->push_back(0xE9);
+            } else {
+                output->push_back(0x0F);
+                output->push_back(op + 0x10);
+            }
+        } else {
+            output->insert(output->end(), code + instruction.opcode_offset,
+                           code + instruction.branch_offset);
+        }
+
+        uintptr_t next = new_address + output->size() + 4;
+        int32_t offset = target - next;
+        uint8_t bytes[4];
+        memcpy(bytes, &offset, 4);
+        output->insert(output->end(), bytes, bytes + 4);
+        position += instruction.length;
+    }
+    return true;
+}
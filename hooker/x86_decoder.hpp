@@ -0,0 +1,65 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Just enough of an x86 decoder to move instructions somewhere else.
+// It only understands 32 bit code, which is all Halo has.
+
+enum X86BranchType : uint8_t {
+    X86_NO_BRANCH,
+    X86_BRANCH_REL8,  // jmp, jcc, loop and jecxz with a 1 byte displacement.
+    X86_BRANCH_REL32  // call, jmp and jcc with a 4 byte displacement.
+};
+
+struct X86Instruction {
+    size_t length;
+    // Where the opcode starts, after any prefixes.
+    size_t opcode_offset;
+    X86BranchType branch;
+    // Where the displacement of a relative branch starts.
+    size_t branch_offset;
+};
+
+// Decodes the instruction at code. Returns false if it isn't one we know.
+bool x86_decode(const uint8_t* code, X86Instruction* instruction);
+
+// Returns the address a relative branch at address goes to.
+uintptr_t x86_branch_target(uintptr_t address, const X86Instruction& instruction);
+
+// Returns how many bytes of whole instructions at address are needed to
+// cover at least min_size bytes. Returns 0 if the code can't be decoded.
+size_t x86_instructions_size(uintptr_t address, size_t min_size);
+
+// Decodes from address up to the first return, at most max_size bytes on.
+// Puts how many bytes of arguments that return pops in pop_size, 0 for a
+// plain ret. Returns false if no return was found. This walks straight on
+// without following branches, which works for compiled functions since all
+// returns of a function pop the same.
+bool x86_find_return(uintptr_t address, size_t max_size, uint16_t* pop_size);
+
+// Copies the instructions in [address, address + size) to output so they
+// can run from new_address. Relative branches are aimed at their original
+// targets again, short ones are turned into long ones to be able to reach.
+// Returns false if the code can't be moved, like when it branches back into
+// itself or uses loop/jecxz which have no long form.
+bool x86_relocate(uintptr_t address, size_t size, uintptr_t new_address,
+                  std::vector<uint8_t>* output);
@@ -0,0 +1,151 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Compares splitting console lines with the command_split regex that
+// process_command used to use with CommandTokenizer. Fails if the two split
+// any of a lot of random lines differently.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <vulpes/command/tokenizer.hpp>
+
+#include "synthetic_code.hpp"
+
+static const int ROUNDS = 5;
+static const size_t RANDOM_LINES = 20000;
+static const size_t LINES_PER_ROUND = 20000;
+
+typedef std::vector<std::string> Words;
+
+static const std::regex command_split("([^\\s\"]+)|\"([^\"]*)\"|\"([^\"]*)");
+
+// How process_command split a line before the tokenizer.
+static Words split_regex(const std::string& input_str) {
+    Words matches;
+    std::smatch arg_match;
+    std::string::const_iterator search_start(input_str.cbegin());
+    while(regex_search(search_start, input_str.cend(), arg_match, command_split)) {
+        if(arg_match[1] != "") {
+            std::string str = arg_match[1];
+            int semicolon_pos = str.find(";");
+            if (semicolon_pos != std::string::npos) {
+                if (semicolon_pos > 0) {
+                    matches.push_back(str.substr(0, semicolon_pos));
+                }
+                break; // We shouldn't match anything after a semicolon
+            }
+            matches.push_back(str);
+        } else if(arg_match[2] != "") {
+            matches.push_back(arg_match[2]);
+        } else if(arg_match[3] != "") {
+            matches.push_back(arg_match[3]);
+        } else {
+            matches.push_back("");
+        }
+        search_start = arg_match.suffix().first;
+    }
+    return matches;
+}
+
+static Words split_tokenizer(const char* line) {
+    Words words;
+    CommandTokenizer tokens(line);
+    std::string_view token;
+    while (tokens.next(&token)) {
+        words.emplace_back(token);
+    }
+    return words;
+}
+
+// Lines are glued together from these, to hit every rule in many orders.
+static const char* PIECES[] = {
+    "vulpes_dev_mode", "sv_say", "cheat_deathless_player", "1", "true",
+    "hello", "2.5", " ", "  ", "\t", "\"", ";", "#", "//", "\"quoted text\"",
+    "a;b", "x\"y",
+};
+
+static std::string random_line(TestRandom& random) {
+    const uint32_t piece_count = sizeof(PIECES) / sizeof(PIECES[0]);
+    std::string line;
+    uint32_t length = random.below(12);
+    for (uint32_t i = 0; i < length; i++) {
+        line += PIECES[random.below(piece_count)];
+    }
+    return line;
+}
+
+// What goes through the console while playing, mostly lines that aren't ours.
+static const char* TYPICAL_LINES[] = {
+    "sv_say \"Welcome to the server\"",
+    "object_create_anew warthog",
+    "cheat_deathless_player true; cheat_infinite_ammo true",
+    "vulpes_dev_mode 1",
+    "sv_map bloodgulch ctf",
+    "game_speed 1.5",
+    "sv_kick 3 \"spamming",
+};
+
+template<typename F>
+static double best_ns_per_line(F function) {
+    const size_t line_count = sizeof(TYPICAL_LINES) / sizeof(TYPICAL_LINES[0]);
+    double best = 1e30;
+    for (int i = 0; i < ROUNDS; i++) {
+        size_t words = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t l = 0; l < LINES_PER_ROUND; l++) {
+            words += function(TYPICAL_LINES[l % line_count]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        if (words == 0) printf("No words?\n");
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / LINES_PER_ROUND);
+    }
+    return best;
+}
+
+int main() {
+    TestRandom random(0xC0DE);
+    for (size_t i = 0; i < RANDOM_LINES; i++) {
+        std::string line = random_line(random);
+        if (split_regex(line) != split_tokenizer(line.c_str())) {
+            printf("FAIL: the tokenizer splits [%s] differently.\n", line.c_str());
+            return 1;
+        }
+    }
+
+    // The old path copied the line and every word. The tokenizer only hands
+    // out views, words only get copied for Vulpes commands.
+    double regex_ns = best_ns_per_line([](const char* line) {
+        return split_regex(std::string(line)).size();
+    });
+    double tokenizer_ns = best_ns_per_line([](const char* line) {
+        size_t words = 0;
+        CommandTokenizer tokens(line);
+        std::string_view token;
+        while (tokens.next(&token)) words++;
+        return words;
+    });
+
+    printf("%zu random lines split the same.\n", RANDOM_LINES);
+    printf("regex:     %8.1f ns per line\n", regex_ns);
+    printf("tokenizer: %8.1f ns per line\n", tokenizer_ns);
+    return 0;
+}
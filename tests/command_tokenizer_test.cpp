@@ -0,0 +1,93 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Pins down how console lines are split into words: quotes, unclosed
+// quotes, semicolons and comment lines. Scripts out there rely on these.
+
+#include <string>
+#include <vector>
+
+#include <vulpes/command/tokenizer.hpp>
+
+#include "check.hpp"
+
+typedef std::vector<std::string> Words;
+
+static Words split(const char* line) {
+    Words words;
+    CommandTokenizer tokens(line);
+    std::string_view token;
+    while (tokens.next(&token)) {
+        words.emplace_back(token);
+    }
+    return words;
+}
+
+static void test_words() {
+    CHECK(split("") == Words());
+    CHECK(split(" \t ") == Words());
+    CHECK(split("vulpes_cmd") == Words({"vulpes_cmd"}));
+    CHECK(split("  cmd   1\t2.5  ") == Words({"cmd", "1", "2.5"}));
+    // Words aren't lowercased, looking commands up ignores case on its own.
+    CHECK(split("Cmd ARG") == Words({"Cmd", "ARG"}));
+}
+
+static void test_quotes() {
+    CHECK(split("say \"hello there\" now") == Words({"say", "hello there", "now"}));
+    CHECK(split("say \"\"") == Words({"say", ""}));
+    // A quote ends the word before it and starts a new one.
+    CHECK(split("a\"b c\"d") == Words({"a", "b c", "d"}));
+    // Semicolons in quotes are just text.
+    CHECK(split("say \"a;b\" c") == Words({"say", "a;b", "c"}));
+}
+
+static void test_unclosed_quote() {
+    CHECK(split("say \"hello there") == Words({"say", "hello there"}));
+    CHECK(split("say \"hello; there") == Words({"say", "hello; there"}));
+    CHECK(split("say \"") == Words({"say", ""}));
+}
+
+static void test_semicolon() {
+    CHECK(split("cmd a;b c") == Words({"cmd", "a"}));
+    CHECK(split("cmd a ;b c") == Words({"cmd", "a"}));
+    CHECK(split("cmd a; \"b\"") == Words({"cmd", "a"}));
+    CHECK(split(";cmd a") == Words());
+}
+
+static void test_comments() {
+    CHECK(is_command_comment(";cmd"));
+    CHECK(is_command_comment("#cmd"));
+    CHECK(is_command_comment("// cmd"));
+    CHECK(is_command_comment("//"));
+    CHECK(!is_command_comment("/cmd"));
+    CHECK(!is_command_comment(" ;cmd"));
+    CHECK(!is_command_comment(" #cmd"));
+    CHECK(!is_command_comment("cmd # not a comment"));
+    CHECK(!is_command_comment(""));
+    // Comment markers later in the line are words like any other.
+    CHECK(split("cmd # x // y") == Words({"cmd", "#", "x", "//", "y"}));
+}
+
+int main() {
+    test_words();
+    test_quotes();
+    test_unclosed_quote();
+    test_semicolon();
+    test_comments();
+
+    return check_result();
+}
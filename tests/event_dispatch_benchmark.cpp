@@ -0,0 +1,180 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Compares how events used to be called, from a vector that was copied for
+// every call and walked once per priority, with EventList. Then compares
+// handlers added as plain functions with ones added with a context or as a
+// lambda. Fails if any of them don't call the handlers in the same order.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include <vulpes/event.hpp>
+
+static const int ROUNDS = 5;
+static const size_t CALLS_PER_ROUND = 1000000;
+
+typedef void (*event_tick)(uint32_t);
+
+// Every handler folds its own number into this, so the result tells the
+// order they were called in.
+static uint32_t call_order_hash = 0;
+
+template<uint32_t number>
+static void handler(uint32_t tick) {
+    call_order_hash = call_order_hash * 31 + number + tick;
+}
+
+template<uint32_t ... numbers>
+static std::vector<event_tick> make_handlers(std::integer_sequence<uint32_t, numbers ...>) {
+    return {&handler<numbers> ...};
+}
+
+static const std::vector<event_tick> handlers = make_handlers(std::make_integer_sequence<uint32_t, 100>());
+
+static uint32_t handler_numbers[100];
+
+static void context_handler(uint32_t *number, uint32_t tick) {
+    call_order_hash = call_order_hash * 31 + *number + tick;
+}
+
+DEFINE_EVENT_HOOK(EVENT_FUNCTION_TICK, void, uint32_t);
+DEFINE_EVENT_HOOK(EVENT_CONTEXT_TICK, void, uint32_t);
+DEFINE_EVENT_HOOK(EVENT_LAMBDA_TICK, void, uint32_t);
+DEFINE_EVENT_HOOK_LIST(EVENT_FUNCTION_TICK, function_tick_events);
+DEFINE_EVENT_HOOK_LIST(EVENT_CONTEXT_TICK, context_tick_events);
+DEFINE_EVENT_HOOK_LIST(EVENT_LAMBDA_TICK, lambda_tick_events);
+
+// What call_in_order looked like before EventList.
+template<typename T, typename ... Args>
+static void call_in_order_by_value(std::vector<Event<T>> events, Args&& ... args) {
+    auto count = events.size();
+    for(typename std::vector<Event<T>>::size_type i=0;i<count;i++) {
+        if(events[i].priority == EVENT_PRIORITY_BEFORE) events[i].function(std::forward<Args>(args) ...);
+    }
+    for(typename std::vector<Event<T>>::size_type i=0;i<count;i++) {
+        if(events[i].priority == EVENT_PRIORITY_DEFAULT) events[i].function(std::forward<Args>(args) ...);
+    }
+    for(typename std::vector<Event<T>>::size_type i=0;i<count;i++) {
+        if(events[i].priority == EVENT_PRIORITY_AFTER) events[i].function(std::forward<Args>(args) ...);
+    }
+    for(typename std::vector<Event<T>>::size_type i=0;i<count;i++) {
+        if(events[i].priority == EVENT_PRIORITY_FINAL) events[i].function(std::forward<Args>(args) ...);
+    }
+}
+
+static EventPriority priority_of(size_t i) {
+    return static_cast<EventPriority>((i * 7) % 4);
+}
+
+template<typename F>
+static double best_ns_per_call(size_t calls, F function) {
+    double best = 1e30;
+    for (int i = 0; i < ROUNDS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t c = 0; c < calls; c++) {
+            function(static_cast<uint32_t>(c));
+        }
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / calls);
+    }
+    return best;
+}
+
+static bool compare(size_t handler_count) {
+    std::vector<Event<event_tick>> by_value;
+    EventList<event_tick> list;
+    for (size_t i = 0; i < handler_count; i++) {
+        by_value.emplace_back(handlers[i], priority_of(i));
+        list.add(handlers[i], priority_of(i));
+    }
+
+    call_order_hash = 0;
+    call_in_order_by_value(by_value, 1u);
+    uint32_t by_value_hash = call_order_hash;
+    call_order_hash = 0;
+    call_in_order(list, 1u);
+    if (call_order_hash != by_value_hash) {
+        printf("FAIL: EventList called %zu handlers in a different order.\n", handler_count);
+        return false;
+    }
+
+    size_t calls = CALLS_PER_ROUND / handler_count;
+    double by_value_ns = best_ns_per_call(calls, [&](uint32_t tick) {
+        call_in_order_by_value(by_value, tick);
+    });
+    double list_ns = best_ns_per_call(calls, [&](uint32_t tick) {
+        call_in_order(list, tick);
+    });
+    printf("%3zu handlers: by value %8.1f ns, EventList %8.1f ns per call\n",
+           handler_count, by_value_ns, list_ns);
+    return true;
+}
+
+// The same handlers, added in the three ways the ADD_CALLBACK macros have.
+static bool compare_callback_kinds(size_t handler_count) {
+    for (size_t i = 0; i < handler_count; i++) {
+        uint32_t *number = &handler_numbers[i];
+        *number = static_cast<uint32_t>(i);
+        ADD_CALLBACK(EVENT_FUNCTION_TICK, handlers[i]);
+        ADD_CALLBACK_C(EVENT_CONTEXT_TICK, context_handler, number);
+        ADD_CALLBACK_LAMBDA(EVENT_LAMBDA_TICK, [number](uint32_t tick) {
+            call_order_hash = call_order_hash * 31 + *number + tick;
+        });
+    }
+
+    uint32_t hashes[3];
+    call_order_hash = 0;
+    call_in_order(function_tick_events, 1u);
+    hashes[0] = call_order_hash;
+    call_order_hash = 0;
+    call_in_order(context_tick_events, 1u);
+    hashes[1] = call_order_hash;
+    call_order_hash = 0;
+    call_in_order(lambda_tick_events, 1u);
+    hashes[2] = call_order_hash;
+    if (hashes[1] != hashes[0] || hashes[2] != hashes[0]) {
+        printf("FAIL: context or lambda handlers were called differently.\n");
+        return false;
+    }
+
+    size_t calls = CALLS_PER_ROUND / handler_count;
+    double function_ns = best_ns_per_call(calls, [](uint32_t tick) {
+        call_in_order(function_tick_events, tick);
+    });
+    double context_ns = best_ns_per_call(calls, [](uint32_t tick) {
+        call_in_order(context_tick_events, tick);
+    });
+    double lambda_ns = best_ns_per_call(calls, [](uint32_t tick) {
+        call_in_order(lambda_tick_events, tick);
+    });
+    printf("%3zu handlers: function %8.1f ns, context %8.1f ns, lambda %8.1f ns per call\n",
+           handler_count, function_ns, context_ns, lambda_ns);
+    return true;
+}
+
+int main() {
+    bool passed = true;
+    for (size_t handler_count : {1, 10, 100}) {
+        passed = compare(handler_count) && passed;
+    }
+    passed = compare_callback_kinds(10) && passed;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Hammers the job system from vulpes/jobs.cpp with lots of small jobs, the
+// way the game thread would, and checks that every job is worked on a worker
+// and delivered on the game thread exactly once.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <util/threads.hpp>
+#include <vulpes/jobs.hpp>
+
+#include "check.hpp"
+
+static const size_t JOB_COUNT = 200000;
+static const size_t JOBS_PER_TICK = 300;
+
+static std::thread::id game_thread;
+static std::atomic<size_t> worked_on_game_thread(0);
+static std::atomic<size_t> delivered_off_game_thread(0);
+static std::vector<int> delivered;
+
+struct TestJob {
+    size_t id;
+    uint32_t result;
+};
+
+static void test_work(void* data) {
+    auto job = reinterpret_cast<TestJob*>(data);
+    if (std::this_thread::get_id() == game_thread) worked_on_game_thread++;
+    // A bit of busy work so jobs overlap.
+    uint32_t value = job->id;
+    for (size_t i = 0; i < job->id % 64; i++) value = value * 1664525 + 1013904223;
+    job->result = value;
+}
+
+static void test_done(void* data) {
+    auto job = reinterpret_cast<TestJob*>(data);
+    if (std::this_thread::get_id() != game_thread) delivered_off_game_thread++;
+    delivered[job->id]++;
+    delete job;
+}
+
+// Lock and Semaphore on their own, with more threads than processors.
+static void test_primitives() {
+    const size_t thread_count = 8;
+    const size_t increments = 100000;
+    Lock lock;
+    Semaphore started;
+    Semaphore go;
+    CHECK(started.valid() && go.valid());
+    size_t counter = 0;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; t++) {
+        threads.emplace_back([&] {
+            started.release();
+            go.wait();
+            for (size_t i = 0; i < increments; i++) {
+                lock.lock();
+                counter++;
+                lock.unlock();
+            }
+        });
+    }
+    for (size_t t = 0; t < thread_count; t++) started.wait();
+    go.release(thread_count);
+    for (auto &thread : threads) thread.join();
+    CHECK(counter == thread_count * increments);
+}
+
+static void test_jobs() {
+    game_thread = std::this_thread::get_id();
+    delivered.assign(JOB_COUNT, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t submitted = 0;
+    size_t delivered_total = 0;
+    size_t ticks = 0;
+    bool over_limit = false;
+    while (delivered_total < JOB_COUNT) {
+        for (size_t i = 0; i < JOBS_PER_TICK && submitted < JOB_COUNT; i++) {
+            run_job(test_work, test_done, new TestJob{submitted++, 0});
+        }
+        size_t count = deliver_finished_jobs(JOBS_DELIVERED_PER_TICK);
+        if (count > JOBS_DELIVERED_PER_TICK) over_limit = true;
+        delivered_total += count;
+        ticks++;
+        if (!count && submitted == JOB_COUNT) std::this_thread::yield();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    size_t wrong = 0;
+    for (auto count : delivered) wrong += count != 1;
+    CHECK(wrong == 0);
+    CHECK(!over_limit);
+    CHECK(delivered_off_game_thread == 0);
+    // With more than one processor the work has to happen on the workers.
+    if (processor_count() > 1) CHECK(worked_on_game_thread == 0);
+    CHECK(deliver_finished_jobs(JOBS_DELIVERED_PER_TICK) == 0);
+
+    // done can be NULL.
+    run_job(test_work, NULL, new TestJob{0, 0});
+    while (!deliver_finished_jobs(1)) std::this_thread::yield();
+
+    printf("%zu jobs delivered over %zu ticks in %.2f ms.\n", JOB_COUNT, ticks,
+           std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+// Once stopped, jobs run right away but are still delivered after a tick.
+static void test_stopped() {
+    stop_workers();
+    delivered.assign(1, 0);
+    size_t before = worked_on_game_thread;
+    run_job(test_work, test_done, new TestJob{0, 0});
+    CHECK(worked_on_game_thread == before + 1);
+    CHECK(delivered[0] == 0);
+    CHECK(deliver_finished_jobs(JOBS_DELIVERED_PER_TICK) == 1);
+    CHECK(delivered[0] == 1);
+}
+
+int main() {
+    test_primitives();
+    test_jobs();
+    test_stopped();
+
+    return check_result();
+}
@@ -0,0 +1,250 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Deferred log lines have to come out exactly like snprintf would have made
+// them, with every conversion, flag, width and precision. Then logs a binary
+// file that was opened twice through vulpes/log.cpp and decodes it again.
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <tools/log_decoder.hpp>
+#include <util/threads.hpp>
+#include <vulpes/log.hpp>
+
+#include "check.hpp"
+
+static const char* LOG_DIRECTORY = "log_format_test_files";
+
+template<typename... Args>
+static std::string expected_text(const char* format, Args... args) {
+    char text[512];
+    snprintf(text, sizeof(text), format, args...);
+    return text;
+}
+
+template<typename... Args>
+static std::string deferred_text(const char* format, Args... args) {
+    LogArgs buffer;
+    (buffer.add(args), ...);
+    char text[512];
+    format_log_args(text, sizeof(text), format, buffer.data, buffer.size);
+    return text;
+}
+
+template<typename... Args>
+static void check_format(const char* format, Args... args) {
+    std::string expected = expected_text(format, args...);
+    std::string deferred = deferred_text(format, args...);
+    if (expected != deferred) {
+        printf("\"%s\": snprintf gave [%s], format_log_args [%s]\n",
+               format, expected.data(), deferred.data());
+    }
+    CHECK(expected == deferred);
+}
+
+static void test_integers() {
+    for (int value : {0, 7, -7, 123456, -2147483647 - 1}) {
+        check_format("%d", value);
+        check_format("%i", value);
+        check_format("[%5d]", value);
+        check_format("[%-5d]", value);
+        check_format("[%05d]", value);
+        check_format("[%+d]", value);
+        check_format("[% d]", value);
+        check_format("[%.3d]", value);
+        check_format("[%8.3d]", value);
+        check_format("[%-+8.3i]", value);
+    }
+    for (unsigned value : {0u, 42u, 0xDEADBEEFu}) {
+        check_format("%u", value);
+        check_format("%x %X", value, value);
+        check_format("[%#x] [%#X] [%#o]", value, value, value);
+        check_format("[%08x]", value);
+        check_format("[%-#10o]", value);
+    }
+    long long big = -1234567890123LL;
+    check_format("%lld %lli", big, big);
+    check_format("%llu %llx", 1234567890123ULL, 0xFEDCBA9876ULL);
+    check_format("[%20lld] [%-20llX]", big, 0xFEDCBA9876ULL);
+    check_format("%zu %zx", static_cast<size_t>(123456789), static_cast<size_t>(0xABC));
+    check_format("%ld", -123456L);
+}
+
+static void test_characters_and_strings() {
+    check_format("%c%c%c", 'a', 'b', 'c');
+    check_format("[%3c] [%-3c]", 'x', 'y');
+    check_format("%s", "text");
+    check_format("[%10s] [%-10s]", "right", "left");
+    check_format("[%.3s] [%8.2s]", "cut off", "cut off");
+    check_format("%s and %s", "", "empty");
+    check_format("100%% %s", "done");
+}
+
+static void test_floating_point() {
+    for (double value : {0.0, 1.5, -2.25, 3.14159265358979, 12345678.9, 1e-7}) {
+        check_format("%f", value);
+        check_format("%F", value);
+        check_format("%e %E", value, value);
+        check_format("%g %G", value, value);
+        check_format("%a %A", value, value);
+        check_format("[%10.3f] [%-10.2f] [%+.1f] [%010.4f]", value, value, value, value);
+        check_format("[% .2e] [%#.0f] [%#g]", value, value, value);
+    }
+    check_format("%f", 2.5f);
+}
+
+static void test_pointers() {
+    int value;
+    check_format("%p", static_cast<void*>(&value));
+    check_format("[%20p] [%-20p]", static_cast<void*>(&value), static_cast<void*>(&value));
+    check_format("%p", static_cast<void*>(NULL));
+}
+
+static void test_star() {
+    check_format("[%*d]", 6, 42);
+    check_format("[%-*d]", 6, 42);
+    check_format("[%*d]", -6, 42);
+    check_format("[%.*f]", 3, 3.14159265358979);
+    check_format("[%*.*f]", 10, 2, 3.14159265358979);
+    check_format("[%*.*s]", 8, 3, "truncated");
+    check_format("[%*s|%-*s]", 5, "a", 5, "b");
+}
+
+static void test_mismatches() {
+    CHECK(deferred_text("%d", "text") == "(?)");
+    CHECK(deferred_text("%s", 5) == "(?)");
+    CHECK(deferred_text("%d %d", 5) == "5 (?)");
+    // Formatting stops at the end of the buffer like snprintf does.
+    LogArgs buffer;
+    buffer.add("a long string");
+    char small[6];
+    CHECK(format_log_args(small, sizeof(small), "%s", buffer.data, buffer.size) == 5);
+    CHECK(strcmp(small, "a lon") == 0);
+}
+
+// Everything after the time, "severity text".
+static std::string without_time(const std::string& line) {
+    const size_t time_length = strlen("2020-01-31 12:00:00 ");
+    return line.size() > time_length ? line.substr(time_length) : "";
+}
+
+static std::string log_line_text(LogSeverity severity, const std::string& text) {
+    char line[600];
+    format_log_line(line, sizeof(line), 0, severity, text.data());
+    return without_time(line);
+}
+
+static size_t count_in_file(const std::string& path, const char* bytes, size_t size) {
+    std::string data;
+    FILE* file = fopen(path.data(), "rb");
+    if (!file) return 0;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) data.append(buffer, read);
+    fclose(file);
+    size_t count = 0;
+    for (size_t at = data.find(bytes, 0, size); at != std::string::npos;
+         at = data.find(bytes, at + 1, size)) {
+        count++;
+    }
+    return count;
+}
+
+// The binary log gets opened again when the log goes to text and back, and
+// the second time the same formats get other ids. The decoder has to forget
+// the ids from before each LOG_ENTRY_START.
+static void test_binary_round_trip() {
+    std::filesystem::remove_all(LOG_DIRECTORY);
+    std::filesystem::create_directories(LOG_DIRECTORY);
+    std::string binary_path = std::string(LOG_DIRECTORY) + "/vulpes.vlog";
+    std::string text_path = std::string(LOG_DIRECTORY) + "/vulpes.log";
+
+    static const char FIRST[] = "first %d %s";
+    static const char SECOND[] = "second %.2f %p [%-*d]";
+    void* pointer = &binary_path;
+
+    set_log_binary(true);
+    init_log(LOG_DIRECTORY);
+    log_deferred(LOG_INFO, FIRST, 1, "one");
+    log_deferred(LOG_WARNING, SECOND, 2.5, pointer, 4, 7);
+    log_line(LOG_ERROR, "plain text");
+    flush_log();
+
+    // The writer thread can be busy, so make sure it switched over.
+    set_log_binary(false);
+    while (!std::filesystem::exists(text_path)) {
+        flush_log();
+        sleep_milliseconds(1);
+    }
+    set_log_binary(true);
+    log_deferred(LOG_ERROR, SECOND, -0.125, pointer, 3, 12);
+    log_deferred(LOG_MESSAGE, FIRST, 2, "two");
+    stop_log();
+    sleep_milliseconds(300);
+    flush_log();
+
+    std::vector<std::string> expected = {
+        log_line_text(LOG_INFO, expected_text(FIRST, 1, "one")),
+        log_line_text(LOG_WARNING, expected_text(SECOND, 2.5, pointer, 4, 7)),
+        log_line_text(LOG_ERROR, "plain text"),
+        log_line_text(LOG_ERROR, expected_text(SECOND, -0.125, pointer, 3, 12)),
+        log_line_text(LOG_MESSAGE, expected_text(FIRST, 2, "two")),
+    };
+
+    CHECK(count_in_file(binary_path, LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC)) == 2);
+
+    FILE* in = fopen(binary_path.data(), "rb");
+    CHECK(in);
+    if (!in) return;
+    std::string decoded_path = std::string(LOG_DIRECTORY) + "/decoded.log";
+    FILE* out = fopen(decoded_path.data(), "wb");
+    size_t lines = 0;
+    CHECK(decode_log(in, out, &lines));
+    fclose(in);
+    fclose(out);
+    CHECK(lines == expected.size());
+
+    out = fopen(decoded_path.data(), "rb");
+    char line[600];
+    size_t number = 0;
+    while (fgets(line, sizeof(line), out)) {
+        std::string text = without_time(line);
+        if (!text.empty() && text.back() == '\n') text.pop_back();
+        bool same = number < expected.size() && text == expected[number];
+        if (!same) printf("Decoded line %zu is [%s]\n", number, text.data());
+        CHECK(same);
+        number++;
+    }
+    fclose(out);
+    CHECK(number == expected.size());
+}
+
+int main() {
+    test_integers();
+    test_characters_and_strings();
+    test_floating_point();
+    test_pointers();
+    test_star();
+    test_mismatches();
+    test_binary_round_trip();
+
+    return check_result();
+}
@@ -0,0 +1,136 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Logs from several threads at once with vulpes/log.cpp, while the writer
+// and the logging threads themselves all try to write the ring buffer out.
+// Every line has to end up in the files exactly once and in order, unless it
+// was counted as dropped, and the files have to be rotated on the way.
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <util/threads.hpp>
+#include <vulpes/log.hpp>
+
+#include "check.hpp"
+
+static const size_t THREAD_COUNT = 4;
+static const size_t LINES_PER_THREAD = 5000;
+static const size_t OVERFLOW_LINES = 100;
+static const char* LOG_DIRECTORY = "log_stress_test_files";
+
+static const char PADDING[] =
+    "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx";
+
+static std::string log_path(size_t number) {
+    std::string path = std::string(LOG_DIRECTORY) + "/vulpes";
+    if (number) path += "." + std::to_string(number);
+    return path + ".log";
+}
+
+static void log_from_thread(size_t thread) {
+    for (size_t n = 0; n < LINES_PER_THREAD; n++) {
+        size_t dropped = log_lines_dropped();
+        if (n % 2) {
+            log_printf(LOG_INFO, "stress %zu %zu %s", thread, n, PADDING);
+        } else {
+            log_deferred(LOG_WARNING, "stress %u %u %s", thread, n, PADDING);
+        }
+        // Without waiting on the disk the ring would be full all of the
+        // time, and rotation would never happen.
+        flush_log();
+        if (log_lines_dropped() != dropped) sleep_milliseconds(1);
+    }
+}
+
+struct Found {
+    size_t stress_lines = 0;
+    size_t overflow_lines = 0;
+    size_t out_of_order = 0;
+    size_t files = 0;
+    size_t oversized_files = 0;
+};
+
+// Reads the files from the oldest to the newest.
+static Found read_logs() {
+    Found found;
+    std::vector<long> last(THREAD_COUNT, -1);
+    for (size_t number = LOG_FILES_KEPT + 1; number-- > 0;) {
+        FILE* file = fopen(log_path(number).data(), "rb");
+        if (!file) continue;
+        found.files++;
+        char line[LOG_LINE_CHARS * 4 + 32];
+        while (fgets(line, sizeof(line), file)) {
+            const char* text = strstr(line, "stress ");
+            unsigned thread;
+            long n;
+            if (text && sscanf(text, "stress %u %ld", &thread, &n) == 2 && thread < THREAD_COUNT) {
+                found.stress_lines++;
+                if (n <= last[thread]) found.out_of_order++;
+                last[thread] = n;
+            } else if (strstr(line, "overflow ")) {
+                found.overflow_lines++;
+            }
+        }
+        if (ftell(file) > static_cast<long>(LOG_FILE_SIZE + sizeof(line))) found.oversized_files++;
+        fclose(file);
+    }
+    return found;
+}
+
+int main() {
+    std::filesystem::remove_all(LOG_DIRECTORY);
+    std::filesystem::create_directories(LOG_DIRECTORY);
+    init_log(LOG_DIRECTORY);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back(log_from_thread, t);
+    }
+    for (auto &thread : threads) thread.join();
+    stop_log();
+    size_t dropped = log_lines_dropped();
+
+    // Give the writer time to see it has to stop. After that nobody empties
+    // the ring, so exactly what doesn't fit in it gets dropped.
+    sleep_milliseconds(300);
+    for (size_t i = 0; i < LOG_LINES_BUFFERED + OVERFLOW_LINES; i++) {
+        log_deferred(LOG_INFO, "overflow %u", i);
+    }
+    CHECK(log_lines_dropped() == dropped + OVERFLOW_LINES);
+    flush_log();
+
+    Found found = read_logs();
+    CHECK(found.stress_lines + dropped == THREAD_COUNT * LINES_PER_THREAD);
+    CHECK(found.out_of_order == 0);
+    CHECK(found.overflow_lines == LOG_LINES_BUFFERED);
+    // About 3 MB went out, so there have to be old files but none were
+    // thrown away yet.
+    CHECK(found.files >= 3 && found.files <= LOG_FILES_KEPT + 1);
+    CHECK(found.oversized_files == 0);
+    FILE* too_old = fopen(log_path(LOG_FILES_KEPT + 1).data(), "rb");
+    CHECK(!too_old);
+    if (too_old) fclose(too_old);
+
+    printf("%zu lines written over %zu files, %zu dropped.\n",
+           found.stress_lines, found.files, dropped);
+    return check_result();
+}
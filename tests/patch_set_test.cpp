@@ -0,0 +1,270 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Applies and reverts CodePatches on real pages through the mprotect backend.
+// Checks that a PatchSet only writes once it is committed, changes every page
+// it touches once, and leaves the pages the way it found them. Then times a
+// set against applying the same patches one at a time.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <hooker/memory_protection.hpp>
+#include <hooker/patch_set.hpp>
+
+#include "check.hpp"
+
+// Counts the calls that go to the real backend.
+class CountingProtection : public MemoryProtection {
+public:
+    size_t writable_calls = 0;
+    size_t restore_calls = 0;
+
+    bool make_writable(uintptr_t address, size_t size,
+                       uint32_t* old_protection) override {
+        writable_calls++;
+        return system.make_writable(address, size, old_protection);
+    }
+    bool restore(uintptr_t address, size_t size,
+                 uint32_t old_protection) override {
+        restore_calls++;
+        return system.restore(address, size, old_protection);
+    }
+    size_t page_size() override {
+        return system.page_size();
+    }
+    uintptr_t allocate_executable(size_t size) override {
+        return system.allocate_executable(size);
+    }
+    void reset() {
+        writable_calls = 0;
+        restore_calls = 0;
+    }
+private:
+    SystemMemoryProtection system;
+};
+
+// Patching prints a line for every patch, which would bury the results.
+class QuietStdout {
+public:
+    QuietStdout() {
+        fflush(stdout);
+        saved = dup(STDOUT_FILENO);
+        FILE* null = fopen("/dev/null", "w");
+        dup2(fileno(null), STDOUT_FILENO);
+        fclose(null);
+    }
+    ~QuietStdout() {
+        fflush(stdout);
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+private:
+    int saved;
+};
+
+// Reads the protection of the mapping address is in from /proc/self/maps,
+// like "r-xp". Empty if it isn't mapped.
+static std::string protection_at(uintptr_t address) {
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        std::istringstream fields(line);
+        std::string range;
+        std::string protection;
+        fields >> range >> protection;
+        auto dash = range.find('-');
+        uintptr_t start = std::stoull(range.substr(0, dash), NULL, 16);
+        uintptr_t end = std::stoull(range.substr(dash + 1), NULL, 16);
+        if (address >= start && address < end) return protection;
+    }
+    return "";
+}
+
+// Pages of NOPs that look like loaded code, readable and executable.
+static uintptr_t make_code_pages(size_t pages, size_t page_size) {
+    uintptr_t code = get_memory_protection()->allocate_executable(pages * page_size);
+    memset(reinterpret_cast<void*>(code), NOP_BYTE, pages * page_size);
+    mprotect(reinterpret_cast<void*>(code), pages * page_size, PROT_READ | PROT_EXEC);
+    return code;
+}
+
+static bool bytes_are(uintptr_t address, const std::vector<int16_t>& bytes) {
+    auto memory = reinterpret_cast<const uint8_t*>(address);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        if (bytes[i] != -1 && memory[i] != bytes[i]) return false;
+    }
+    return true;
+}
+
+static void test_patch_set(CountingProtection* protection) {
+    size_t page_size = protection->page_size();
+    uintptr_t code = make_code_pages(3, page_size);
+    CHECK(code != 0);
+    CHECK(protection_at(code) == "r-xp");
+
+    // Two patches on the first page, one across the first and second.
+    // The third page is never touched.
+    std::vector<int16_t> bytes = {0xE8, 0x11, 0x22, 0x33, 0x44, 0xC3};
+    std::vector<int16_t> masked = {0xB8, -1, -1, -1, -1};
+    CodePatch first("first", code + 0x10, bytes);
+    CodePatch second("second", code + 0x40, masked);
+    CodePatch across("across", code + page_size - 3, bytes);
+
+    PatchSet set;
+    {
+        QuietStdout quiet;
+        first.build();
+        second.build();
+        across.build();
+
+        open_patch_set(&set);
+        first.apply();
+        second.apply();
+        across.apply();
+        close_patch_set();
+    }
+    // Nothing is written until the set is committed.
+    CHECK(set.size() == 3);
+    CHECK(!first.applied() && !across.applied());
+    CHECK(bytes_are(code + 0x10, {NOP_BYTE, NOP_BYTE, NOP_BYTE}));
+
+    protection->reset();
+    {
+        QuietStdout quiet;
+        set.commit();
+    }
+    CHECK(set.size() == 0);
+    CHECK(protection->writable_calls == 2);
+    CHECK(protection->restore_calls == 2);
+    CHECK(first.applied() && second.applied() && across.applied());
+    CHECK(bytes_are(code + 0x10, bytes));
+    CHECK(bytes_are(code + 0x40, {0xB8, NOP_BYTE, NOP_BYTE, NOP_BYTE, NOP_BYTE}));
+    CHECK(bytes_are(code + page_size - 3, bytes));
+    CHECK(first.integrity() && second.integrity() && across.integrity());
+    CHECK(protection_at(code) == "r-xp");
+    CHECK(protection_at(code + page_size) == "r-xp");
+    CHECK(protection_at(code + page_size * 2) == "r-xp");
+
+    // set_call_address doesn't wait for an open set.
+    PatchSet other;
+    open_patch_set(&other);
+    set_call_address(code + 0x10, code + 0x1000);
+    close_patch_set();
+    CHECK(other.size() == 0);
+    CHECK(get_call_address(code + 0x10) == code + 0x1000);
+    {
+        // Reverting puts back what was there when the patch was built.
+        QuietStdout quiet;
+        open_patch_set(&set);
+        first.revert();
+        second.revert();
+        across.revert();
+        close_patch_set();
+        set.commit();
+    }
+    CHECK(!first.applied() && !second.applied() && !across.applied());
+    CHECK(bytes_are(code + 0x10, {NOP_BYTE, NOP_BYTE, NOP_BYTE, NOP_BYTE, NOP_BYTE, NOP_BYTE}));
+    CHECK(bytes_are(code + page_size - 3, {NOP_BYTE, NOP_BYTE, NOP_BYTE, NOP_BYTE, NOP_BYTE, NOP_BYTE}));
+    CHECK(protection_at(code) == "r-xp");
+
+    // Without an open set a patch is written right away.
+    protection->reset();
+    {
+        QuietStdout quiet;
+        first.apply();
+    }
+    CHECK(first.applied() && bytes_are(code + 0x10, bytes));
+    CHECK(protection->writable_calls == 1);
+
+    munmap(reinterpret_cast<void*>(code), page_size * 3);
+}
+
+static const size_t BENCHMARK_PAGES = 64;
+static const size_t PATCHES_PER_PAGE = 32;
+
+static double patch_all_ms(std::vector<std::unique_ptr<CodePatch>>& patches, bool use_set) {
+    QuietStdout quiet;
+    auto start = std::chrono::steady_clock::now();
+    PatchSet set;
+    if (use_set) open_patch_set(&set);
+    for (auto &patch : patches) patch->apply();
+    if (use_set) {
+        close_patch_set();
+        set.commit();
+    }
+    if (use_set) open_patch_set(&set);
+    for (auto &patch : patches) patch->revert();
+    if (use_set) {
+        close_patch_set();
+        set.commit();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void benchmark(CountingProtection* protection) {
+    size_t page_size = protection->page_size();
+    uintptr_t code = make_code_pages(BENCHMARK_PAGES, page_size);
+    std::vector<std::unique_ptr<CodePatch>> patches;
+    {
+        QuietStdout quiet;
+        size_t spacing = page_size / PATCHES_PER_PAGE;
+        for (size_t i = 0; i < BENCHMARK_PAGES * PATCHES_PER_PAGE; i++) {
+            patches.emplace_back(new CodePatch("bench", code + i * spacing,
+                std::vector<int16_t>{0xE9, 0x00, 0x00, 0x00, 0x00}));
+            patches.back()->build();
+        }
+    }
+
+    protection->reset();
+    double one_by_one = patch_all_ms(patches, false);
+    size_t one_by_one_calls = protection->writable_calls;
+    protection->reset();
+    double with_set = patch_all_ms(patches, true);
+    size_t with_set_calls = protection->writable_calls;
+
+    CHECK(with_set_calls == BENCHMARK_PAGES * 2);
+    CHECK(protection_at(code) == "r-xp");
+
+    printf("Applying and reverting %zu patches on %zu pages:\n",
+           patches.size(), BENCHMARK_PAGES);
+    printf("one at a time: %8.2f ms, %zu protection changes\n", one_by_one, one_by_one_calls);
+    printf("patch set:     %8.2f ms, %zu protection changes\n", with_set, with_set_calls);
+
+    munmap(reinterpret_cast<void*>(code), page_size * BENCHMARK_PAGES);
+}
+
+int main() {
+    // The patches go to freshly mapped memory, nowhere near Halo.
+    set_lowest_permitted_address(0);
+    CountingProtection protection;
+    set_memory_protection(&protection);
+
+    test_patch_set(&protection);
+    benchmark(&protection);
+
+    return check_result();
+}
@@ -0,0 +1,230 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Reads a small 32 bit image with four sections that is built right here,
+// and broken versions of it:
+//
+//   cut off inside of the file header or halfway through a section header
+//   a PE header offset far past the end of the file
+//   "PX" instead of "PE"
+//   65535 sections
+//   an optional header so big the section table is past the end
+//   an optional header too short to hold SizeOfImage
+//
+// Also checks that signature hints can't make a scan leave the image.
+
+#include <cstdio>
+#include <cstring>
+
+#include <hooker/pe.hpp>
+#include <hooker/signature_scanner.hpp>
+
+#include "check.hpp"
+#include "synthetic_code.hpp"
+
+// Where things are in the image make_image builds.
+static const size_t IMAGE_FILE_SIZE = 0x600;
+static const size_t PE_OFFSET = 0x40;
+static const size_t FILE_HEADER = PE_OFFSET + 4;
+static const size_t OPTIONAL_HEADER = FILE_HEADER + 20;
+static const size_t OPTIONAL_HEADER_SIZE = 0xE0;
+static const size_t SECTION_TABLE = OPTIONAL_HEADER + OPTIONAL_HEADER_SIZE;
+static const size_t SECTION_HEADER_SIZE = 40;
+static const size_t HEADERS_END = SECTION_TABLE + 4 * SECTION_HEADER_SIZE;
+
+static void put16(std::vector<uint8_t>& image, size_t offset, uint16_t value) {
+    image[offset] = value & 0xFF;
+    image[offset + 1] = value >> 8;
+}
+
+static void put32(std::vector<uint8_t>& image, size_t offset, uint32_t value) {
+    put16(image, offset, value & 0xFFFF);
+    put16(image, offset + 2, value >> 16);
+}
+
+static void put_section(std::vector<uint8_t>& image, size_t index, const char* name,
+                        uint32_t virtual_address, uint32_t virtual_size,
+                        uint32_t raw_offset, uint32_t raw_size, uint32_t flags) {
+    size_t header = SECTION_TABLE + index * SECTION_HEADER_SIZE;
+    memcpy(&image[header], name, strnlen(name, 8));
+    put32(image, header + 8, virtual_size);
+    put32(image, header + 12, virtual_address);
+    put32(image, header + 16, raw_size);
+    put32(image, header + 20, raw_offset);
+    put32(image, header + 36, flags);
+}
+
+// Just the fields a loader needs, the way a linker would write them.
+static std::vector<uint8_t> make_image() {
+    std::vector<uint8_t> image(IMAGE_FILE_SIZE, 0);
+    image[0] = 'M';
+    image[1] = 'Z';
+    put32(image, 0x3C, PE_OFFSET);
+    memcpy(&image[PE_OFFSET], "PE\0\0", 4);
+
+    put16(image, FILE_HEADER, 0x14C); // i386
+    put16(image, FILE_HEADER + 2, 4); // sections
+    put32(image, FILE_HEADER + 4, 0x5E000000); // timestamp
+    put16(image, FILE_HEADER + 16, OPTIONAL_HEADER_SIZE);
+    put16(image, FILE_HEADER + 18, 0x0102); // executable, 32 bit
+
+    put16(image, OPTIONAL_HEADER, 0x10B); // PE32
+    put32(image, OPTIONAL_HEADER + 16, 0x1000); // entry point
+    put32(image, OPTIONAL_HEADER + 28, 0x400000); // image base
+    put32(image, OPTIONAL_HEADER + 32, 0x1000); // section alignment
+    put32(image, OPTIONAL_HEADER + 36, 0x200); // file alignment
+    put32(image, OPTIONAL_HEADER + 56, 0x5000); // SizeOfImage
+    put32(image, OPTIONAL_HEADER + 60, 0x200); // SizeOfHeaders
+    put32(image, OPTIONAL_HEADER + 92, 16); // data directories
+
+    put_section(image, 0, ".text", 0x1000, 0x10, 0x200, 0x200,
+                PE_SECTION_CODE | PE_SECTION_EXECUTE | PE_SECTION_READ);
+    put_section(image, 1, ".rdata", 0x2000, 0, 0x400, 0x200,
+                PE_SECTION_INITIALIZED | PE_SECTION_READ);
+    put_section(image, 2, ".data", 0x3000, 0x800, 0, 0,
+                PE_SECTION_INITIALIZED | PE_SECTION_READ | PE_SECTION_WRITE);
+    put_section(image, 3, ".textbss", 0x4000, 0x100, 0, 0,
+                0x80 | PE_SECTION_EXECUTE | PE_SECTION_READ | PE_SECTION_WRITE);
+    image[0x200] = 0xC3; // ret
+    return image;
+}
+
+static std::vector<uint8_t> cut_off(std::vector<uint8_t> image, size_t size) {
+    image.resize(size);
+    return image;
+}
+
+static void test_valid_image() {
+    auto image = make_image();
+
+    std::vector<PeSection> sections;
+    CHECK(pe_read_sections(image.data(), image.size(), &sections));
+    CHECK(sections.size() == 4);
+
+    auto text = pe_find_section(sections, ".text");
+    CHECK(text && text->virtual_address == 0x1000 && text->size() == 0x10);
+    CHECK(text && text->flags & PE_SECTION_EXECUTE);
+    CHECK(text && text->raw_offset == 0x200 && image[text->raw_offset] == 0xC3);
+    // No virtual size, so the raw size is used.
+    auto rdata = pe_find_section(sections, ".rdata");
+    CHECK(rdata && rdata->size() == 0x200);
+    // A name that fills all 8 bytes still gets terminated.
+    CHECK(pe_find_section(sections, ".textbss") != NULL);
+    CHECK(pe_find_section(sections, ".reloc") == NULL);
+
+    uint32_t image_size = 0;
+    CHECK(pe_read_image_size(image.data(), image.size(), &image_size));
+    CHECK(image_size == 0x5000);
+}
+
+// Every cut short copy of the headers has to be refused, without reading past
+// the end. Each copy gets its own allocation of exactly that size so memory
+// checkers notice if we do.
+static void test_every_truncation() {
+    auto image = make_image();
+    for (size_t size = 0; size < HEADERS_END; size++) {
+        std::vector<uint8_t> cut(image.begin(), image.begin() + size);
+        std::vector<PeSection> sections;
+        bool read = pe_read_sections(cut.data(), cut.size(), &sections);
+        CHECK(!read && sections.empty());
+        if (read) printf("Read sections from only %zu bytes.\n", size);
+    }
+    std::vector<uint8_t> exact(image.begin(), image.begin() + HEADERS_END);
+    std::vector<PeSection> sections;
+    CHECK(pe_read_sections(exact.data(), exact.size(), &sections));
+    CHECK(sections.size() == 4);
+}
+
+static void test_malformed() {
+    auto truncated_file_header = cut_off(make_image(), FILE_HEADER + 12);
+    auto truncated_section_table = cut_off(make_image(), HEADERS_END - SECTION_HEADER_SIZE / 2);
+    auto pe_offset_out_of_file = make_image();
+    put32(pe_offset_out_of_file, 0x3C, 0xFFFFFFFE);
+    auto bad_pe_magic = make_image();
+    bad_pe_magic[PE_OFFSET + 1] = 'X';
+    auto too_many_sections = make_image();
+    put16(too_many_sections, FILE_HEADER + 2, 0xFFFF);
+    auto optional_header_too_big = make_image();
+    put16(optional_header_too_big, FILE_HEADER + 16, 0xFFFF);
+    auto optional_header_too_small = make_image();
+    put16(optional_header_too_small, FILE_HEADER + 16, 32);
+
+    for (auto image : {truncated_file_header, truncated_section_table,
+                       pe_offset_out_of_file, bad_pe_magic,
+                       too_many_sections, optional_header_too_big}) {
+        std::vector<PeSection> sections;
+        bool read = pe_read_sections(image.data(), image.size(), &sections);
+        CHECK(!read && sections.empty());
+    }
+
+    for (auto image : {truncated_file_header, pe_offset_out_of_file,
+                       bad_pe_magic, optional_header_too_small}) {
+        uint32_t image_size = 0;
+        CHECK(!pe_read_image_size(image.data(), image.size(), &image_size));
+    }
+}
+
+// Lays out [outside][image][outside] and puts the same bytes in each part.
+// Hints that reach far past the image may only find the copy inside of it.
+static void test_hints_stay_in_image() {
+    const size_t part = 0x10000;
+    std::vector<uint8_t> memory(part * 3, 0x90);
+    const uint8_t pattern[] = {0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6};
+    uintptr_t start = reinterpret_cast<uintptr_t>(memory.data());
+    uintptr_t image_start = start + part;
+    memcpy(memory.data() + 0x100, pattern, sizeof(pattern));
+    memcpy(memory.data() + part + 0x100, pattern, sizeof(pattern));
+    memcpy(memory.data() + part * 2 + 0x100, pattern, sizeof(pattern));
+    // Straddles the end of the image, so it mustn't be found either.
+    memcpy(memory.data() + part * 2 - 3, pattern, sizeof(pattern));
+
+    PeSection text = {".text", 0, static_cast<uint32_t>(part), 0, 0, PE_SECTION_CODE};
+    set_executable_sections(image_start, part, {text});
+
+    auto sig = make_synthetic_signature("pattern", {0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6});
+    uintptr_t inside = image_start + 0x100;
+
+    SignatureRegion window;
+    window.start_address = start;
+    window.end_address = start + memory.size();
+    SignatureRegion near;
+    near.near = &inside;
+    near.near_distance = UINTPTR_MAX;
+    SignatureRegion section;
+    section.section = ".text";
+
+    for (auto region : {window, near, section}) {
+        std::vector<uintptr_t> results;
+        SignatureScanner scanner;
+        scanner.add_multiple(sig->signature.get(), &results, region);
+        scanner.scan(start, start + memory.size());
+        CHECK(results == std::vector<uintptr_t>{inside});
+    }
+
+    set_executable_sections(0, 0, {});
+}
+
+int main() {
+    set_signature_search_quiet(true);
+
+    test_valid_image();
+    test_every_truncation();
+    test_malformed();
+    test_hints_stay_in_image();
+
+    return check_result();
+}
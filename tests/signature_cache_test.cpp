@@ -0,0 +1,84 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include <hooker/signature_cache.hpp>
+
+#include "check.hpp"
+#include "synthetic_code.hpp"
+
+int main() {
+    auto code = make_synthetic_code(0x1000, 7);
+    uintptr_t start = reinterpret_cast<uintptr_t>(code.data());
+    uintptr_t end = start + code.size();
+    auto hit = make_synthetic_signature("hit", {code[0x100], code[0x101], code[0x102], code[0x103]});
+    auto miss = make_synthetic_signature("miss", {0xDE, 0xAD, 0xBE, 0xEF, 0x13, 0x37});
+    const char* path = "signature_cache_test.cache";
+    remove(path);
+
+    {
+        SignatureCache cache(path, 0x1234);
+        cache.load();
+        uintptr_t found = hit->signature->search(start, end);
+        CHECK(found);
+        cache.store(hit->signature.get(), found, start, end);
+        cache.store(miss->signature.get(), 0, start, end);
+        cache.store_multiple(miss->signature.get(), {}, start, end);
+
+        uintptr_t result = 1;
+        CHECK(cache.lookup(hit->signature.get(), &result, start, end));
+        CHECK(result == found);
+        // Misses are never trusted, they need to be searched for again.
+        CHECK(!cache.lookup(miss->signature.get(), &result, start, end));
+        std::vector<uintptr_t> results;
+        CHECK(!cache.lookup_multiple(miss->signature.get(), &results, start, end));
+
+        cache.save();
+        FILE* file = fopen(path, "r");
+        char text[256] = {};
+        fread(text, 1, sizeof(text) - 1, file);
+        fclose(file);
+        CHECK(strstr(text, "hit "));
+        CHECK(!strstr(text, "miss "));
+    }
+
+    // A cache file from before misses stopped being stored.
+    FILE* file = fopen(path, "w");
+    fprintf(file, "vulpes_signature_cache 2 00001234\nmiss 00000000 0\n");
+    fclose(file);
+    {
+        SignatureCache cache(path, 0x1234);
+        cache.load();
+        uintptr_t result = 1;
+        CHECK(!cache.lookup(miss->signature.get(), &result, start, end));
+    }
+
+    // Something that moved doesn't come out of the cache.
+    {
+        SignatureCache cache(path, 0x1234);
+        uintptr_t found = hit->signature->search(start, end);
+        cache.store(hit->signature.get(), found, start, end);
+        code[found - start] ^= 0xFF;
+        uintptr_t result = 0;
+        CHECK(!cache.lookup(hit->signature.get(), &result, start, end));
+    }
+
+    remove(path);
+    return check_result();
+}
@@ -0,0 +1,114 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Compares searching for every signature on its own with the single pass
+// SignatureMatcher does, over a synthetic 2 MB code image. Fails if the two
+// don't find exactly the same addresses.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include <hooker/signature_match.hpp>
+
+#include "synthetic_code.hpp"
+
+static const size_t IMAGE_SIZE = 2 * 1024 * 1024;
+static const size_t SIGNATURE_COUNT = 100;
+static const int ROUNDS = 5;
+
+struct Results {
+    std::vector<uintptr_t> single;
+    std::vector<std::vector<uintptr_t>> multi;
+};
+
+typedef std::vector<std::unique_ptr<SyntheticSignature>> Signatures;
+
+static Results search_each(Signatures& signatures, uintptr_t start, uintptr_t end) {
+    Results results;
+    for (auto &sig : signatures) {
+        if (sig->multi) {
+            results.multi.push_back(sig->signature->search_multiple(start, end));
+        } else {
+            results.single.push_back(sig->signature->search(start, end));
+        }
+    }
+    return results;
+}
+
+static Results search_single_pass(Signatures& signatures, uintptr_t start, uintptr_t end) {
+    SignatureMatcher matcher(start, end);
+    for (auto &sig : signatures) {
+        matcher.add(sig->signature.get(), !sig->multi);
+    }
+    matcher.prepare();
+    for (size_t c = 0; c < matcher.chunk_count(); c++) {
+        matcher.scan_chunk(c);
+    }
+    Results results;
+    for (size_t i = 0; i < signatures.size(); i++) {
+        if (signatures[i]->multi) {
+            results.multi.push_back(matcher.results(i));
+        } else {
+            results.single.push_back(matcher.result(i));
+        }
+    }
+    return results;
+}
+
+template<typename F>
+static double best_ms(F function) {
+    double best = 1e30;
+    for (int i = 0; i < ROUNDS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+int main() {
+    set_signature_search_quiet(true);
+
+    auto code = make_synthetic_code(IMAGE_SIZE, 0x5EED);
+    auto signatures = make_synthetic_signatures(code, SIGNATURE_COUNT, 0xF0C5);
+    uintptr_t start = reinterpret_cast<uintptr_t>(code.data());
+    uintptr_t end = start + code.size();
+
+    Results each = search_each(signatures, start, end);
+    Results single_pass = search_single_pass(signatures, start, end);
+
+    size_t found = 0;
+    size_t multi_hits = 0;
+    for (auto result : each.single) found += result != 0;
+    for (auto &results : each.multi) multi_hits += results.size();
+
+    if (each.single != single_pass.single || each.multi != single_pass.multi) {
+        printf("FAIL: the single pass found different addresses than searching one by one.\n");
+        return 1;
+    }
+
+    double each_ms = best_ms([&] { search_each(signatures, start, end); });
+    double single_pass_ms = best_ms([&] { search_single_pass(signatures, start, end); });
+
+    printf("%zu signatures over %zu KiB: %zu of %zu singles found, %zu multi hits.\n",
+           signatures.size(), IMAGE_SIZE / 1024, found, each.single.size(), multi_hits);
+    printf("one by one:  %8.2f ms\n", each_ms);
+    printf("single pass: %8.2f ms\n", single_pass_ms);
+    return 0;
+}
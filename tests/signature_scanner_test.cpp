@@ -0,0 +1,167 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Checks that spreading a scan over threads finds exactly what searching for
+// each signature on its own finds, including matches that cross the edge of
+// a chunk and the order of multi signature results. Then times both.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <hooker/signature_scanner.hpp>
+#include <util/threads.hpp>
+
+#include "check.hpp"
+#include "synthetic_code.hpp"
+
+static const size_t IMAGE_SIZE = 2 * 1024 * 1024;
+static const size_t SIGNATURE_COUNT = 100;
+
+typedef std::vector<std::unique_ptr<SyntheticSignature>> Signatures;
+
+struct Results {
+    std::vector<uintptr_t> single;
+    std::vector<std::vector<uintptr_t>> multi;
+};
+
+static Results search_serial(Signatures& signatures, uintptr_t start, uintptr_t end) {
+    Results results;
+    for (auto &sig : signatures) {
+        if (sig->multi) {
+            results.multi.push_back(sig->signature->search_multiple(start, end));
+        } else {
+            results.single.push_back(sig->signature->search(start, end));
+        }
+    }
+    return results;
+}
+
+static Results search_scanner(Signatures& signatures, uintptr_t start, uintptr_t end,
+                              size_t threads) {
+    set_signature_scan_threads(threads);
+    Results results;
+    results.single.resize(signatures.size());
+    results.multi.resize(signatures.size());
+    SignatureScanner scanner;
+    for (size_t i = 0; i < signatures.size(); i++) {
+        if (signatures[i]->multi) {
+            scanner.add_multiple(signatures[i]->signature.get(), &results.multi[i]);
+        } else {
+            scanner.add(signatures[i]->signature.get(), &results.single[i]);
+        }
+    }
+    scanner.scan(start, end);
+
+    // Pack them like search_serial does.
+    Results packed;
+    for (size_t i = 0; i < signatures.size(); i++) {
+        if (signatures[i]->multi) {
+            packed.multi.push_back(results.multi[i]);
+        } else {
+            packed.single.push_back(results.single[i]);
+        }
+    }
+    return packed;
+}
+
+// The scanner splits the range into thread_count * 4 chunks of at least
+// 64 KiB, this is where the edges end up.
+static std::vector<uintptr_t> chunk_edges(uintptr_t start, uintptr_t end, size_t threads) {
+    uintptr_t range = end - start;
+    uintptr_t chunk_size = std::max<uintptr_t>(range / (threads * 4) + 1, 0x10000);
+    std::vector<uintptr_t> edges;
+    for (uintptr_t edge = start + chunk_size; edge < end; edge += chunk_size) {
+        edges.push_back(edge);
+    }
+    return edges;
+}
+
+template<typename F>
+static double best_ms(F function) {
+    double best = 1e30;
+    for (int i = 0; i < 5; i++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+int main() {
+    set_signature_search_quiet(true);
+
+    auto code = make_synthetic_code(IMAGE_SIZE, 0xC0DE);
+    uintptr_t start = reinterpret_cast<uintptr_t>(code.data());
+    uintptr_t end = start + code.size();
+
+    // A pattern that is put across every chunk edge, and right at the start
+    // of every chunk, for a 4 thread scan. Nothing else in the image has it.
+    const uint8_t pattern[] = {0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8};
+    for (size_t i = 0; i + sizeof(pattern) <= code.size(); i++) {
+        if (code[i] == 0xF1) code[i] = 0x90;
+    }
+    auto edges = chunk_edges(start, end, 4);
+    CHECK(edges.size() > 4);
+    std::vector<uintptr_t> planted;
+    for (auto edge : edges) {
+        memcpy(reinterpret_cast<void*>(edge - 3), pattern, sizeof(pattern));
+        planted.push_back(edge - 3);
+        memcpy(reinterpret_cast<void*>(edge + 16), pattern, sizeof(pattern));
+        planted.push_back(edge + 16);
+    }
+
+    Signatures signatures = make_synthetic_signatures(code, SIGNATURE_COUNT, 0xBEEF);
+    // Anchored on its last byte, so only the chunk before the edge sees it.
+    auto across = make_synthetic_signature("across", {0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8});
+    across->multi = true;
+    auto first_across = make_synthetic_signature("first_across", {0xF1, 0xF2, 0xF3, -1, 0xF5, 0xF6, 0xF7, 0xF8});
+    signatures.push_back(std::move(across));
+    signatures.push_back(std::move(first_across));
+
+    Results serial = search_serial(signatures, start, end);
+    CHECK(serial.multi.back() == planted);
+    CHECK(serial.single.back() == planted[0]);
+
+    for (size_t threads : {1, 2, 3, 4, 8}) {
+        Results scanned = search_scanner(signatures, start, end, threads);
+        CHECK(scanned.single == serial.single);
+        CHECK(scanned.multi == serial.multi);
+        if (scanned.single != serial.single || scanned.multi != serial.multi) {
+            printf("Differs from the serial search with %zu threads.\n", threads);
+        }
+    }
+
+    // Ranges that don't start on anything special, or are too small to split.
+    Results small_serial = search_serial(signatures, start + 7, start + 0x12345);
+    Results small_scanned = search_scanner(signatures, start + 7, start + 0x12345, 4);
+    CHECK(small_scanned.single == small_serial.single);
+    CHECK(small_scanned.multi == small_serial.multi);
+
+    double serial_ms = best_ms([&] { search_serial(signatures, start, end); });
+    double one_ms = best_ms([&] { search_scanner(signatures, start, end, 1); });
+    size_t threads = processor_count() > 1 ? processor_count() : 2;
+    double many_ms = best_ms([&] { search_scanner(signatures, start, end, threads); });
+    printf("%zu signatures over %zu KiB:\n", signatures.size(), IMAGE_SIZE / 1024);
+    printf("serial, one by one:     %8.2f ms\n", serial_ms);
+    printf("scanner, 1 thread:      %8.2f ms\n", one_ms);
+    printf("scanner, %2zu threads:    %8.2f ms\n", threads, many_ms);
+
+    return check_result();
+}
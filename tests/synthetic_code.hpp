@@ -0,0 +1,170 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <hooker/hooker.hpp>
+
+// A made up image of 32 bit x86 code, and signatures cut out of it the same
+// way CodeGen builds them from signatures.yaml. Everything comes from a seed,
+// so every run looks at the same bytes.
+
+class TestRandom {
+public:
+    TestRandom(uint32_t seed) : state(seed ? seed : 1) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint32_t below(uint32_t limit) {
+        return next() % limit;
+    }
+private:
+    uint32_t state;
+};
+
+// Instructions that show up a lot in Halo's code. xx is a random byte.
+static const char* SYNTHETIC_INSTRUCTIONS[] = {
+    "8B 44 24 xx", "89 4C 24 xx", "8B 0D xx xx xx xx", "E8 xx xx xx xx",
+    "83 C4 xx", "85 C0", "74 xx", "75 xx", "0F 84 xx xx xx xx", "50", "51",
+    "53", "55", "56", "57", "5E", "5F", "C3", "8D 4C 24 xx",
+    "FF 15 xx xx xx xx", "33 C0", "C7 44 24 xx xx xx xx xx", "6A xx",
+    "0F BF xx", "66 8B 46 xx", "D9 44 24 xx", "A1 xx xx xx xx", "EB xx",
+    "8A 44 24 xx", "84 C0", "81 EC xx xx 00 00", "CC CC CC CC",
+};
+
+inline std::vector<uint8_t> make_synthetic_code(size_t size, uint32_t seed) {
+    TestRandom random(seed);
+    std::vector<uint8_t> code;
+    code.reserve(size + 16);
+    const size_t instruction_count =
+        sizeof(SYNTHETIC_INSTRUCTIONS) / sizeof(SYNTHETIC_INSTRUCTIONS[0]);
+    while (code.size() < size) {
+        const char* text = SYNTHETIC_INSTRUCTIONS[random.below(instruction_count)];
+        for (const char* c = text; *c; c += (c[2] ? 3 : 2)) {
+            if (c[0] == 'x') {
+                code.push_back(random.next());
+            } else {
+                code.push_back(std::stoul(std::string(c, 2), NULL, 16));
+            }
+        }
+    }
+    code.resize(size);
+    return code;
+}
+
+// Same list as COMMON_CODE_BYTES in CodeGen/Signature.pm.
+static const uint8_t SYNTHETIC_COMMON_BYTES[] = {
+    0x00, 0xFF, 0x8B, 0x24, 0x89, 0x44, 0x04, 0x08, 0x01, 0x0F,
+    0x83, 0xE8, 0x85, 0x10, 0x50, 0x74, 0xC4, 0x0C, 0x4C, 0x54,
+    0x02, 0x14, 0x18, 0x75, 0x56, 0x57, 0x8D, 0xC0, 0x33, 0xC3,
+    0x20, 0xEB, 0x40, 0x5E, 0x5F, 0xC7, 0x03, 0x46, 0x80, 0x84,
+    0x1C, 0x6A, 0x55, 0x53, 0xCC, 0x90, 0xD9, 0xD8, 0x05, 0x15,
+};
+
+inline size_t synthetic_byte_commonness(uint8_t byte) {
+    const size_t count = sizeof(SYNTHETIC_COMMON_BYTES);
+    for (size_t i = 0; i < count; i++) {
+        if (SYNTHETIC_COMMON_BYTES[i] == byte) return count - i;
+    }
+    return 0;
+}
+
+// Owns the tables a LiteSignature points at.
+struct SyntheticSignature {
+    std::string name;
+    std::vector<uint8_t> values;
+    std::vector<uint8_t> masks;
+    std::vector<uint8_t> skip;
+    std::unique_ptr<LiteSignature> signature;
+    bool multi = false;
+};
+
+// Builds a signature like CodeGen would. -1 in bytes is a wildcard.
+inline std::unique_ptr<SyntheticSignature> make_synthetic_signature(
+        const std::string& name, const std::vector<int16_t>& bytes) {
+    auto sig = std::unique_ptr<SyntheticSignature>(new SyntheticSignature);
+    sig->name = name;
+    size_t anchor = 0;
+    bool have_anchor = false;
+    for (size_t i = 0; i < bytes.size(); i++) {
+        bool wildcard = bytes[i] < 0;
+        sig->values.push_back(wildcard ? 0x00 : bytes[i]);
+        sig->masks.push_back(wildcard ? 0x00 : 0xFF);
+        if (!wildcard && (!have_anchor
+        || synthetic_byte_commonness(bytes[i]) < synthetic_byte_commonness(bytes[anchor]))) {
+            anchor = i;
+            have_anchor = true;
+        }
+    }
+    size_t solid_run = 0;
+    while (solid_run < bytes.size() && bytes[solid_run] >= 0) solid_run++;
+    const uint8_t* skip = NULL;
+    if (solid_run >= 32) {
+        size_t default_shift = solid_run > 255 ? 255 : solid_run;
+        sig->skip.assign(256, default_shift);
+        for (size_t i = 0; i + 1 < solid_run; i++) {
+            size_t shift = solid_run - 1 - i;
+            sig->skip[bytes[i]] = shift > 255 ? 255 : shift;
+        }
+        skip = sig->skip.data();
+    }
+    sig->signature.reset(new LiteSignature{
+        sig->name.data(), bytes.size(), sig->values.data(), sig->masks.data(),
+        anchor, solid_run, skip
+    });
+    return sig;
+}
+
+// Cuts count signatures out of code at random places. Some get wildcards
+// over what would be an address, some get changed so they can't be found,
+// and every tenth one is a multi signature.
+inline std::vector<std::unique_ptr<SyntheticSignature>> make_synthetic_signatures(
+        const std::vector<uint8_t>& code, size_t count, uint32_t seed) {
+    TestRandom random(seed);
+    std::vector<std::unique_ptr<SyntheticSignature>> signatures;
+    for (size_t i = 0; i < count; i++) {
+        size_t length = 8 + random.below(33);
+        size_t offset = random.below(code.size() - length);
+        std::vector<int16_t> bytes(code.begin() + offset, code.begin() + offset + length);
+        if (i % 3 == 1 && length > 8) {
+            size_t wildcard_at = 2 + random.below(length - 6);
+            for (size_t w = 0; w < 4; w++) bytes[wildcard_at + w] = -1;
+        }
+        if (i % 7 == 3) {
+            // Flip a byte, this one is very unlikely to be anywhere.
+            size_t at = random.below(length);
+            if (bytes[at] < 0) bytes[at] = 0;
+            bytes[at] ^= 0x5A;
+        }
+        if (i % 10 == 9) {
+            // Short and common, so there are plenty of matches.
+            bytes.assign({0x8B, 0x44, 0x24, -1, 0x89});
+        }
+        auto sig = make_synthetic_signature("sig" + std::to_string(i), bytes);
+        sig->multi = i % 10 == 9;
+        signatures.push_back(std::move(sig));
+    }
+    return signatures;
+}
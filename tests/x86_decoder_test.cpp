@@ -0,0 +1,290 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Runs the x86 decoder over a corpus of 32 bit instructions with known
+// lengths, and checks that relocated code still branches to where it did,
+// or is refused when it can't be moved.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <hooker/detour.hpp>
+#include <hooker/x86_decoder.hpp>
+
+#include "check.hpp"
+
+struct Case {
+    const char* text;
+    std::vector<uint8_t> code;
+    // 0 for code the decoder has to refuse.
+    size_t length;
+    size_t opcode_offset;
+    X86BranchType branch;
+    size_t branch_offset;
+};
+
+static const Case CORPUS[] = {
+    // ModRM without displacement, with disp8 and with disp32.
+    {"mov eax, ecx",              {0x8B, 0xC1}, 2, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [ecx]",            {0x8B, 0x01}, 2, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [ecx+8]",          {0x8B, 0x41, 0x08}, 3, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [ecx+0x100]",      {0x8B, 0x81, 0x00, 0x01, 0x00, 0x00}, 6, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [0x12345678]",     {0x8B, 0x05, 0x78, 0x56, 0x34, 0x12}, 6, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [ebp]",            {0x8B, 0x45, 0x00}, 3, 0, X86_NO_BRANCH, 0},
+    // SIB forms.
+    {"mov eax, [esp]",            {0x8B, 0x04, 0x24}, 3, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [esp+8]",          {0x8B, 0x44, 0x24, 0x08}, 4, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [esp+0x100]",      {0x8B, 0x84, 0x24, 0x00, 0x01, 0x00, 0x00}, 7, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [eax+ecx*4]",      {0x8B, 0x04, 0x88}, 3, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [ecx*4+0x1000]",   {0x8B, 0x04, 0x8D, 0x00, 0x10, 0x00, 0x00}, 7, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [ebp+ecx*4+8]",    {0x8B, 0x44, 0x8D, 0x08}, 4, 0, X86_NO_BRANCH, 0},
+    {"lea ecx, [esp+0x10]",       {0x8D, 0x4C, 0x24, 0x10}, 4, 0, X86_NO_BRANCH, 0},
+    // ModRM and an immediate.
+    {"mov dword [esp+8], 1",      {0xC7, 0x44, 0x24, 0x08, 0x01, 0x00, 0x00, 0x00}, 8, 0, X86_NO_BRANCH, 0},
+    {"mov dword [esp+0x100], 1",  {0xC7, 0x84, 0x24, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00}, 11, 0, X86_NO_BRANCH, 0},
+    {"sub esp, 0x10",             {0x83, 0xEC, 0x10}, 3, 0, X86_NO_BRANCH, 0},
+    {"sub esp, 0x1000",           {0x81, 0xEC, 0x00, 0x10, 0x00, 0x00}, 6, 0, X86_NO_BRANCH, 0},
+    {"test cl, 1",                {0xF6, 0xC1, 0x01}, 3, 0, X86_NO_BRANCH, 0},
+    {"test ecx, 0x100",           {0xF7, 0xC1, 0x00, 0x01, 0x00, 0x00}, 6, 0, X86_NO_BRANCH, 0},
+    {"neg eax",                   {0xF7, 0xD8}, 2, 0, X86_NO_BRANCH, 0},
+    {"movzx eax, byte [esp+8]",   {0x0F, 0xB6, 0x44, 0x24, 0x08}, 5, 0, X86_NO_BRANCH, 0},
+    {"nop dword [eax+eax]",       {0x0F, 0x1F, 0x44, 0x00, 0x00}, 5, 0, X86_NO_BRANCH, 0},
+    {"shld eax, ecx, 4",          {0x0F, 0xA4, 0xC8, 0x04}, 4, 0, X86_NO_BRANCH, 0},
+    {"fld dword [esp+4]",         {0xD9, 0x44, 0x24, 0x04}, 4, 0, X86_NO_BRANCH, 0},
+    // No ModRM.
+    {"push ebp",                  {0x55}, 1, 0, X86_NO_BRANCH, 0},
+    {"push 0x12345678",           {0x68, 0x78, 0x56, 0x34, 0x12}, 5, 0, X86_NO_BRANCH, 0},
+    {"push 1",                    {0x6A, 0x01}, 2, 0, X86_NO_BRANCH, 0},
+    {"mov eax, [moffs32]",        {0xA1, 0x78, 0x56, 0x34, 0x12}, 5, 0, X86_NO_BRANCH, 0},
+    {"mov eax, 1",                {0xB8, 0x01, 0x00, 0x00, 0x00}, 5, 0, X86_NO_BRANCH, 0},
+    {"ret 8",                     {0xC2, 0x08, 0x00}, 3, 0, X86_NO_BRANCH, 0},
+    {"enter 0x10, 0",             {0xC8, 0x10, 0x00, 0x00}, 4, 0, X86_NO_BRANCH, 0},
+    {"call [0x12345678]",         {0xFF, 0x15, 0x78, 0x56, 0x34, 0x12}, 6, 0, X86_NO_BRANCH, 0},
+    {"jmp [eax*4+0x1000]",        {0xFF, 0x24, 0x85, 0x00, 0x10, 0x00, 0x00}, 7, 0, X86_NO_BRANCH, 0},
+    // 0x66 makes immediates 2 bytes.
+    {"mov ax, 0x1234",            {0x66, 0xB8, 0x34, 0x12}, 4, 1, X86_NO_BRANCH, 0},
+    {"mov word [esp+8], 0x1234",  {0x66, 0xC7, 0x44, 0x24, 0x08, 0x34, 0x12}, 7, 1, X86_NO_BRANCH, 0},
+    {"test cx, 0x100",            {0x66, 0xF7, 0xC1, 0x00, 0x01}, 5, 1, X86_NO_BRANCH, 0},
+    {"add ax, 0x1234",            {0x66, 0x05, 0x34, 0x12}, 4, 1, X86_NO_BRANCH, 0},
+    {"mov ax, [ecx+8]",           {0x66, 0x8B, 0x41, 0x08}, 4, 1, X86_NO_BRANCH, 0},
+    // 0x67 makes addressing 16 bit.
+    {"mov eax, [bx]",             {0x67, 0x8B, 0x07}, 3, 1, X86_NO_BRANCH, 0},
+    {"mov eax, [0x1234]",         {0x67, 0x8B, 0x06, 0x34, 0x12}, 5, 1, X86_NO_BRANCH, 0},
+    {"mov eax, [bx+8]",           {0x67, 0x8B, 0x47, 0x08}, 4, 1, X86_NO_BRANCH, 0},
+    {"mov eax, [bx+0x100]",       {0x67, 0x8B, 0x87, 0x00, 0x01}, 5, 1, X86_NO_BRANCH, 0},
+    {"mov eax, [moffs16]",        {0x67, 0xA1, 0x34, 0x12}, 4, 1, X86_NO_BRANCH, 0},
+    {"mov ax, [bx+si]",           {0x66, 0x67, 0x8B, 0x00}, 4, 2, X86_NO_BRANCH, 0},
+    // Other prefixes.
+    {"mov eax, fs:[0]",           {0x64, 0xA1, 0x00, 0x00, 0x00, 0x00}, 6, 1, X86_NO_BRANCH, 0},
+    {"lock add [ecx], eax",       {0xF0, 0x01, 0x01}, 3, 1, X86_NO_BRANCH, 0},
+    {"rep movsd",                 {0xF3, 0xA5}, 2, 1, X86_NO_BRANCH, 0},
+    // Relative branches.
+    {"jz rel8",                   {0x74, 0x10}, 2, 0, X86_BRANCH_REL8, 1},
+    {"jmp rel8",                  {0xEB, 0xFE}, 2, 0, X86_BRANCH_REL8, 1},
+    {"loop rel8",                 {0xE2, 0x10}, 2, 0, X86_BRANCH_REL8, 1},
+    {"jecxz rel8",                {0xE3, 0x10}, 2, 0, X86_BRANCH_REL8, 1},
+    {"jz rel8, hinted",           {0x3E, 0x74, 0x10}, 3, 1, X86_BRANCH_REL8, 2},
+    {"call rel32",                {0xE8, 0x00, 0x01, 0x00, 0x00}, 5, 0, X86_BRANCH_REL32, 1},
+    {"jmp rel32",                 {0xE9, 0x00, 0x01, 0x00, 0x00}, 5, 0, X86_BRANCH_REL32, 1},
+    {"jnz rel32",                 {0x0F, 0x85, 0x00, 0x01, 0x00, 0x00}, 6, 0, X86_BRANCH_REL32, 2},
+    // Things we refuse.
+    {"jz rel16",                  {0x66, 0x0F, 0x84, 0x34, 0x12}, 0, 0, X86_NO_BRANCH, 0},
+    {"call rel16",                {0x66, 0xE8, 0x34, 0x12}, 0, 0, X86_NO_BRANCH, 0},
+    {"jz rel8 with 0x66",         {0x66, 0x74, 0x10}, 0, 0, X86_NO_BRANCH, 0},
+    {"invalid 0F 04",             {0x0F, 0x04}, 0, 0, X86_NO_BRANCH, 0},
+    {"15 prefixes",               {0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+                                   0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x90}, 0, 0, X86_NO_BRANCH, 0},
+};
+
+static void test_corpus() {
+    for (auto &test : CORPUS) {
+        // Pad so the decoder can't read past the end of the vector.
+        std::vector<uint8_t> code = test.code;
+        code.resize(code.size() + 16, 0xCC);
+        X86Instruction instruction;
+        bool decoded = x86_decode(code.data(), &instruction);
+        bool right;
+        if (test.length == 0) {
+            right = !decoded;
+        } else {
+            right = decoded
+                 && instruction.length == test.length
+                 && instruction.opcode_offset == test.opcode_offset
+                 && instruction.branch == test.branch
+                 && (test.branch == X86_NO_BRANCH
+                  || instruction.branch_offset == test.branch_offset);
+        }
+        CHECK(right);
+        if (!right) {
+            printf("  %s: decoded %d, length %zu, opcode at %zu, branch %d at %zu\n",
+                   test.text, decoded, decoded ? instruction.length : 0,
+                   instruction.opcode_offset, instruction.branch, instruction.branch_offset);
+        }
+    }
+}
+
+// Original code goes at the start of the buffer, relocated code after it, so
+// everything is within reach of a rel32.
+struct RelocateBuffer {
+    std::vector<uint8_t> memory = std::vector<uint8_t>(0x2000, 0xCC);
+    uintptr_t original() { return reinterpret_cast<uintptr_t>(memory.data()) + 0x100; }
+    uintptr_t moved() { return reinterpret_cast<uintptr_t>(memory.data()) + 0x1000; }
+
+    void set_code(const std::vector<uint8_t>& code) {
+        memcpy(reinterpret_cast<void*>(original()), code.data(), code.size());
+    }
+    bool relocate(size_t size, std::vector<uint8_t>* output) {
+        if (!x86_relocate(original(), size, moved(), output)) return false;
+        memcpy(reinterpret_cast<void*>(moved()), output->data(), output->size());
+        return true;
+    }
+    // Where every relative branch goes, for code starting at address.
+    std::vector<uintptr_t> targets(uintptr_t address, size_t size) {
+        std::vector<uintptr_t> found;
+        size_t position = 0;
+        while (position < size) {
+            X86Instruction instruction;
+            if (!x86_decode(reinterpret_cast<const uint8_t*>(address + position),
+                            &instruction)) {
+                found.push_back(0);
+                break;
+            }
+            if (instruction.branch != X86_NO_BRANCH) {
+                found.push_back(x86_branch_target(address + position, instruction));
+            }
+            position += instruction.length;
+        }
+        return found;
+    }
+};
+
+static void test_relocate() {
+    RelocateBuffer buffer;
+    std::vector<uint8_t> output;
+
+    // A prologue without branches is copied as is.
+    std::vector<uint8_t> prologue = {0x55, 0x8B, 0xEC, 0x83, 0xEC, 0x10};
+    buffer.set_code(prologue);
+    CHECK(x86_instructions_size(buffer.original(), 5) == 6);
+    CHECK(buffer.relocate(6, &output));
+    CHECK(output == prologue);
+
+    // Every kind of branch still goes where it went before. Short ones grow
+    // into long ones and the branch hint stays in front.
+    std::vector<uint8_t> branches = {
+        0x74, 0x40,                         // jz +0x40
+        0xEB, 0x30,                         // jmp +0x30
+        0x3E, 0x75, 0x20,                   // jnz +0x20, hinted
+        0xE8, 0x00, 0x02, 0x00, 0x00,       // call +0x200
+        0x0F, 0x8C, 0x00, 0x01, 0x00, 0x00, // jl +0x100
+        0xE9, 0x80, 0xFF, 0xFF, 0xFF,       // jmp -0x80
+    };
+    buffer.set_code(branches);
+    CHECK(buffer.relocate(branches.size(), &output));
+    CHECK(output.size() == 6 + 5 + 7 + 5 + 6 + 5);
+    CHECK(output[0] == 0x0F && output[1] == 0x84);
+    CHECK(output[6] == 0xE9);
+    CHECK(output[11] == 0x3E && output[12] == 0x0F && output[13] == 0x85);
+    CHECK(buffer.targets(buffer.moved(), output.size())
+       == buffer.targets(buffer.original(), branches.size()));
+
+    // A branch right past the stolen bytes is fine, that code stays put.
+    buffer.set_code({0x74, 0x03, 0x55, 0x8B, 0xEC});
+    CHECK(buffer.relocate(5, &output));
+    CHECK(buffer.targets(buffer.moved(), output.size())
+       == std::vector<uintptr_t>{buffer.original() + 5});
+
+    // Branches into the stolen bytes would land in our jump, so refuse them.
+    buffer.set_code({0x74, 0x01, 0x55, 0x8B, 0xEC}); // jz to the push
+    CHECK(!buffer.relocate(5, &output));
+    buffer.set_code({0x55, 0x8B, 0xEC, 0xEB, 0xFB}); // jmp back to the start
+    CHECK(!buffer.relocate(5, &output));
+    buffer.set_code({0x55, 0xE9, 0xFA, 0xFF, 0xFF, 0xFF}); // jmp rel32 to the start
+    CHECK(!buffer.relocate(6, &output));
+    buffer.set_code({0x0F, 0x84, 0x00, 0x00, 0x00, 0x00}); // jz to the next instruction
+    CHECK(buffer.relocate(6, &output));
+
+    // loop and jecxz have no long form.
+    buffer.set_code({0xE2, 0x40, 0x55, 0x8B, 0xEC});
+    CHECK(!buffer.relocate(5, &output));
+    buffer.set_code({0xE3, 0x40, 0x55, 0x8B, 0xEC});
+    CHECK(!buffer.relocate(5, &output));
+}
+
+static bool before_hook(uint32_t* arguments) {
+    return true;
+}
+
+static void after_hook(uint32_t* result) {
+}
+
+static bool contains(const uint8_t* code, size_t size, const std::vector<uint8_t>& bytes) {
+    for (size_t i = 0; i + bytes.size() <= size; i++) {
+        if (memcmp(code + i, bytes.data(), bytes.size()) == 0) return true;
+    }
+    return false;
+}
+
+// Detour::build has to give up on functions the relocator refuses, and on
+// functions that pop their own arguments.
+static void test_detour() {
+    set_lowest_permitted_address(0);
+    RelocateBuffer buffer;
+
+    buffer.set_code({0x55, 0x8B, 0xEC, 0x83, 0xEC, 0x10, 0x8B, 0xE5, 0x5D, 0xC3});
+    Detour good("good", before_hook, nullptr);
+    CHECK(good.build(buffer.original()));
+    CHECK(good.trampoline() != 0);
+
+    // The thunk comes right after the 6 moved bytes and the jump back.
+    Detour both("both", before_hook, after_hook, 2);
+    CHECK(both.build(buffer.original()));
+    const uint8_t* thunk = reinterpret_cast<const uint8_t*>(both.trampoline() + 6 + 5);
+    // Around the after hook eax, ecx and edx are saved.
+    CHECK(contains(thunk, 64, {0x51, 0x52, 0x50, 0x54, 0xE8}));
+    CHECK(contains(thunk, 64, {0x83, 0xC4, 0x04, 0x58, 0x5A, 0x59, 0xC3}));
+
+    // while (...) at the very top of the function.
+    buffer.set_code({0x85, 0xC0, 0x74, 0xFC, 0x90, 0x90, 0xC3});
+    Detour loop("loop", before_hook, nullptr);
+    CHECK(!loop.build(buffer.original()));
+    CHECK(!loop.is_built());
+
+    // stdcall, ret 8 after a branch that doesn't end the function.
+    buffer.set_code({0x55, 0x8B, 0xEC, 0x85, 0xC0, 0x74, 0x01, 0x90, 0x5D, 0xC2, 0x08, 0x00});
+    Detour callee_pops("callee_pops", before_hook, nullptr);
+    CHECK(!callee_pops.build(buffer.original()));
+    Detour callee_pops_after("callee_pops_after", nullptr, after_hook, 2);
+    CHECK(!callee_pops_after.build(buffer.original()));
+
+    uint16_t popped = 0;
+    CHECK(x86_find_return(buffer.original(), 0x100, &popped) && popped == 8);
+    // Code we can't decode before any return.
+    buffer.set_code({0x55, 0x0F, 0x04, 0xC3});
+    CHECK(!x86_find_return(buffer.original(), 0x100, &popped));
+    Detour unknown("unknown", before_hook, nullptr);
+    CHECK(!unknown.build(buffer.original()));
+}
+
+int main() {
+    test_corpus();
+    test_relocate();
+    test_detour();
+
+    return check_result();
+}
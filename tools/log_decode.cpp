@@ -0,0 +1,55 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+// Turns a binary vulpes.vlog into the same text vulpes.log would have had.
+//
+// Usage: vulpes_log_decode <vulpes.vlog> [output.log]
+
+#include <cstdio>
+
+#include "log_decoder.hpp"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <vulpes.vlog> [output.log]\n", argv[0]);
+        return 1;
+    }
+    FILE* in = fopen(argv[1], "rb");
+    if (!in) {
+        fprintf(stderr, "Couldn't open %s\n", argv[1]);
+        return 1;
+    }
+    FILE* out = stdout;
+    if (argc > 2) {
+        out = fopen(argv[2], "wb");
+        if (!out) {
+            fprintf(stderr, "Couldn't open %s\n", argv[2]);
+            return 1;
+        }
+    }
+
+    size_t lines;
+    bool broken = !decode_log(in, out, &lines);
+
+    if (broken) {
+        fprintf(stderr, "%s is broken after %u lines, it might have been cut off.\n",
+                argv[1], static_cast<unsigned>(lines));
+    }
+    fclose(in);
+    if (out != stdout) fclose(out);
+    return broken ? 2 : 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <vulpes/log_format.hpp>
+
+#include "log_decoder.hpp"
+
+template<typename T>
+static bool read_value(FILE* file, T* value) {
+    return fread(value, sizeof(T), 1, file) == 1;
+}
+
+static bool read_string(FILE* file, size_t length, std::string* out) {
+    out->resize(length);
+    return length == 0 || fread(&(*out)[0], 1, length, file) == length;
+}
+
+bool decode_log(FILE* in, FILE* out, size_t* lines) {
+    std::unordered_map<uint32_t, std::string> formats;
+    std::string format;
+    std::string text;
+    char formatted[1024];
+    char line[sizeof(formatted) + 32];
+    bool broken = false;
+    *lines = 0;
+
+    uint8_t type;
+    while (!broken && read_value(in, &type)) {
+        switch (type) {
+        case LOG_ENTRY_START: {
+            char magic[sizeof(LOG_BINARY_MAGIC)];
+            uint8_t version;
+            broken = fread(magic, 1, sizeof(magic), in) != sizeof(magic)
+                  || memcmp(magic, LOG_BINARY_MAGIC, sizeof(magic)) != 0
+                  || !read_value(in, &version)
+                  || version != LOG_BINARY_VERSION;
+            formats.clear();
+            break;
+        }
+        case LOG_ENTRY_FORMAT: {
+            uint32_t id;
+            uint16_t length;
+            broken = !read_value(in, &id) || !read_value(in, &length)
+                  || !read_string(in, length, &format);
+            formats[id] = format;
+            break;
+        }
+        case LOG_ENTRY_LINE:
+        case LOG_ENTRY_TEXT: {
+            int64_t time;
+            uint8_t severity;
+            uint32_t id = 0;
+            uint16_t size;
+            broken = !read_value(in, &time) || !read_value(in, &severity)
+                  || (type == LOG_ENTRY_LINE && !read_value(in, &id))
+                  || !read_value(in, &size) || !read_string(in, size, &text);
+            if (broken) break;
+
+            const char* line_text = text.data();
+            if (type == LOG_ENTRY_LINE) {
+                auto found = formats.find(id);
+                if (found == formats.end()) {
+                    snprintf(formatted, sizeof(formatted), "(unknown format %u)", id);
+                } else {
+                    format_log_args(formatted, sizeof(formatted), found->second.data(),
+                                    reinterpret_cast<const uint8_t*>(text.data()),
+                                    text.size());
+                }
+                line_text = formatted;
+            }
+            format_log_line(line, sizeof(line), time,
+                            static_cast<LogSeverity>(severity), line_text);
+            fprintf(out, "%s\n", line);
+            (*lines)++;
+            break;
+        }
+        default:
+            broken = true;
+            break;
+        }
+    }
+    return !broken;
+}
@@ -0,0 +1,217 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "threads.hpp"
+
+struct ThreadStart {
+    ThreadFunction function;
+    void* param;
+};
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_main(LPVOID param) {
+    auto start = reinterpret_cast<ThreadStart*>(param);
+    ThreadStart copy = *start;
+    delete start;
+    copy.function(copy.param);
+    return 0;
+}
+
+bool start_thread(ThreadFunction function, void* param) {
+    auto start = new ThreadStart{function, param};
+    HANDLE thread = CreateThread(NULL, 0, thread_main, start, 0, NULL);
+    if (!thread) {
+        delete start;
+        return false;
+    }
+    CloseHandle(thread);
+    return true;
+}
+
+void yield_thread() {
+    Sleep(0);
+}
+
+void sleep_milliseconds(unsigned milliseconds) {
+    Sleep(milliseconds);
+}
+
+size_t processor_count() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
+Lock::Lock() {
+    auto section = new CRITICAL_SECTION;
+    InitializeCriticalSection(section);
+    data = section;
+}
+
+Lock::~Lock() {
+    auto section = reinterpret_cast<CRITICAL_SECTION*>(data);
+    DeleteCriticalSection(section);
+    delete section;
+}
+
+void Lock::lock() {
+    EnterCriticalSection(reinterpret_cast<CRITICAL_SECTION*>(data));
+}
+
+void Lock::unlock() {
+    LeaveCriticalSection(reinterpret_cast<CRITICAL_SECTION*>(data));
+}
+
+Semaphore::Semaphore() {
+    data = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
+}
+
+Semaphore::~Semaphore() {
+    if (data) CloseHandle(data);
+}
+
+bool Semaphore::valid() {
+    return data != NULL;
+}
+
+void Semaphore::release(size_t count) {
+    ReleaseSemaphore(data, count, NULL);
+}
+
+void Semaphore::wait() {
+    WaitForSingleObject(data, INFINITE);
+}
+
+#else
+
+static void* thread_main(void* param) {
+    auto start = reinterpret_cast<ThreadStart*>(param);
+    ThreadStart copy = *start;
+    delete start;
+    copy.function(copy.param);
+    return NULL;
+}
+
+bool start_thread(ThreadFunction function, void* param) {
+    auto start = new ThreadStart{function, param};
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, thread_main, start) != 0) {
+        delete start;
+        return false;
+    }
+    pthread_detach(thread);
+    return true;
+}
+
+void yield_thread() {
+    sched_yield();
+}
+
+void sleep_milliseconds(unsigned milliseconds) {
+    timespec time;
+    time.tv_sec = milliseconds / 1000;
+    time.tv_nsec = (milliseconds % 1000) * 1000000L;
+    // Signals wake us up early, with how much time is left in time.
+    while (nanosleep(&time, &time) != 0) {}
+}
+
+size_t processor_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+}
+
+
+Lock::Lock() {
+    auto mutex = new pthread_mutex_t;
+    pthread_mutex_init(mutex, NULL);
+    data = mutex;
+}
+
+Lock::~Lock() {
+    auto mutex = reinterpret_cast<pthread_mutex_t*>(data);
+    pthread_mutex_destroy(mutex);
+    delete mutex;
+}
+
+void Lock::lock() {
+    pthread_mutex_lock(reinterpret_cast<pthread_mutex_t*>(data));
+}
+
+void Lock::unlock() {
+    pthread_mutex_unlock(reinterpret_cast<pthread_mutex_t*>(data));
+}
+
+// Not every system has unnamed POSIX semaphores, so it's a counter
+// behind a condition variable.
+struct SemaphoreData {
+    pthread_mutex_t mutex;
+    pthread_cond_t available;
+    size_t count;
+};
+
+Semaphore::Semaphore() {
+    auto semaphore = new SemaphoreData;
+    pthread_mutex_init(&semaphore->mutex, NULL);
+    pthread_cond_init(&semaphore->available, NULL);
+    semaphore->count = 0;
+    data = semaphore;
+}
+
+Semaphore::~Semaphore() {
+    auto semaphore = reinterpret_cast<SemaphoreData*>(data);
+    pthread_cond_destroy(&semaphore->available);
+    pthread_mutex_destroy(&semaphore->mutex);
+    delete semaphore;
+}
+
+bool Semaphore::valid() {
+    return true;
+}
+
+void Semaphore::release(size_t count) {
+    auto semaphore = reinterpret_cast<SemaphoreData*>(data);
+    pthread_mutex_lock(&semaphore->mutex);
+    semaphore->count += count;
+    pthread_mutex_unlock(&semaphore->mutex);
+    if (count == 1) {
+        pthread_cond_signal(&semaphore->available);
+    } else if (count > 1) {
+        pthread_cond_broadcast(&semaphore->available);
+    }
+}
+
+void Semaphore::wait() {
+    auto semaphore = reinterpret_cast<SemaphoreData*>(data);
+    pthread_mutex_lock(&semaphore->mutex);
+    while (semaphore->count == 0) {
+        pthread_cond_wait(&semaphore->available, &semaphore->mutex);
+    }
+    semaphore->count--;
+    pthread_mutex_unlock(&semaphore->mutex);
+}
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+
+// The little bit of threading Vulpes needs. Win32 in the mod, pthreads
+// everywhere else, so the code using it can be tested on other systems.
+
+typedef void (*ThreadFunction)(void* param);
+
+// Starts a thread that nobody waits for. False if it couldn't be started.
+bool start_thread(ThreadFunction function, void* param);
+
+// Lets another thread have the rest of our time slice.
+void yield_thread();
+
+// Puts this thread to sleep for at least this long.
+void sleep_milliseconds(unsigned milliseconds);
+
+// How many processors the system has, at least 1.
+size_t processor_count();
+
+// A lock for short critical sections. Not recursive.
+class Lock {
+public:
+    Lock();
+    ~Lock();
+    void lock();
+    void unlock();
+private:
+    Lock(const Lock&) = delete;
+    Lock& operator=(const Lock&) = delete;
+    void* data;
+};
+
+// A counting semaphore, for threads waiting on work.
+class Semaphore {
+public:
+    Semaphore();
+    ~Semaphore();
+    // False if the system couldn't give us one.
+    bool valid();
+    // Adds count, waking up as many waiting threads.
+    void release(size_t count = 1);
+    // Waits until the count is above 0, then takes one off.
+    void wait();
+private:
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+    void* data;
+};
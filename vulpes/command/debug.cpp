@@ -15,18 +15,24 @@
  * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
  */
 
-#include <vulpes/hooks/tick.hpp>
 #include <vulpes/fixes/shdr_trans_zfighting.hpp>
 #include <vulpes/functions/messaging.hpp>
+#include <vulpes/log.hpp>
 #include <vulpes/memory/gamestate/network.hpp>
 #include <vulpes/network/network_id.hpp>
 #include <vulpes/debug/budget.hpp>
+#include <vulpes/debug/tick_profiler.hpp>
+#include <vulpes/memory/global.hpp>
+#include <vulpes/paths.hpp>
+#ifdef VULPES_EVENT_TIMING
+#include <vulpes/debug/event_timing.hpp>
+#endif
 
 #include "debug.hpp"
 #include "handler.hpp"
 
 
-bool toggle_shader_trans_fix(std::vector<VulpesArg> input) {
+bool toggle_shader_trans_fix(VulpesArgSpan input) {
     bool on = input[0].bool_out();
     if (on) {
         init_shdr_trans_zfighting_fixes();
@@ -38,7 +44,7 @@ bool toggle_shader_trans_fix(std::vector<VulpesArg> input) {
     return true;
 }
 
-bool toggle_allow_client_side_projectiles(std::vector<VulpesArg> input) {
+bool toggle_allow_client_side_projectiles(VulpesArgSpan input) {
     if (input.size() > 0) {
         bool on = input[0].bool_out();
         *allow_client_side_projectiles() = on;
@@ -57,31 +63,141 @@ bool toggle_allow_client_side_projectiles(std::vector<VulpesArg> input) {
     return true;
 }
 
-bool get_network_id_from_obj_id(std::vector<VulpesArg> input) {
+bool get_network_id_from_obj_id(VulpesArgSpan input) {
     uint32_t id = input[0].int_out();
     cprintf("%d", get_network_id_from_object(*reinterpret_cast<MemRef*>(&id)));
     return true;
 }
 
-bool get_object_id_from_network_id(std::vector<VulpesArg> input) {
+bool get_object_id_from_network_id(VulpesArgSpan input) {
     uint32_t id = input[0].int_out();
     cprintf("0x%X", get_object_from_network_index(id));
     return true;
 }
 
-bool toggle_cprint_budget(std::vector<VulpesArg> input) {
+bool toggle_budget_overlay(VulpesArgSpan input) {
     bool on = input[0].bool_out();
+    if (on) {
+        // Tables get counted twice a second, unless told otherwise.
+        int ticks = 15;
+        if (input.size() > 1 && input[1].time_ticks() > 0) {
+            ticks = input[1].time_ticks();
+        }
+        show_budget_overlay(ticks);
+    } else {
+        hide_budget_overlay();
+    }
+    return true;
+}
 
+bool toggle_tick_profiler(VulpesArgSpan input) {
+    bool on = input[0].bool_out();
+    set_tick_profiler(on);
     if (on) {
-        ADD_CALLBACK_P(EVENT_TICK, cprint_budget, EVENT_PRIORITY_FINAL);
+        cprintf("Turned ON the tick profiler.");
     } else {
-        DEL_CALLBACK(EVENT_TICK, cprint_budget);
+        cprintf("Turned OFF the tick profiler.");
     }
+    return true;
+}
+
+bool print_tick_profile(VulpesArgSpan input) {
+    cprint_tick_profile();
+    return true;
+}
 
+bool dump_tick_profile_csv(VulpesArgSpan input) {
+    auto path = std::string(profile_path()) + TICK_PROFILE_PATH;
+    if (!dump_tick_profile(path.data())) {
+        cprintf_error("Couldn't write %s", path.data());
+        return false;
+    }
+    cprintf("Wrote %s", path.data());
     return true;
 }
 
-static bool print_about(std::vector<VulpesArg> input) {
+#ifdef VULPES_EVENT_TIMING
+
+bool toggle_event_timing(VulpesArgSpan input) {
+    bool on = input[0].bool_out();
+    set_event_timing(on);
+    if (on) {
+        cprintf("Turned ON event timing.");
+    } else {
+        cprintf("Turned OFF event timing.");
+    }
+    return true;
+}
+
+bool print_worst_event_handlers(VulpesArgSpan input) {
+    size_t count = 10;
+    if (input.size() > 0) {
+        count = input[0].int_out();
+    }
+    cprint_event_timing(count);
+    return true;
+}
+
+bool set_event_handler_budget(VulpesArgSpan input) {
+    float microseconds = input[0].flt_out();
+    uint32_t calls = 1;
+    EventBudgetAction action = EVENT_BUDGET_WARN;
+    if (input.size() > 1) {
+        calls = input[1].int_out();
+    }
+    if (input.size() > 2) {
+        std::string_view name = input[2].str_out();
+        if (name == "demote") {
+            action = EVENT_BUDGET_DEMOTE;
+        } else if (name == "disable") {
+            action = EVENT_BUDGET_DISABLE;
+        } else if (name != "warn") {
+            cprintf_error("Action needs to be warn, demote or disable.");
+            return false;
+        }
+    }
+    set_event_budget(microseconds, calls, action);
+    return true;
+}
+
+#endif
+
+static bool set_log_severity_filter(VulpesArgSpan input) {
+    static const char* names[LOG_SEVERITIES] = {
+        "message", "info", "warning", "error"
+    };
+    std::string_view name = input[0].str_out();
+    int severity = 0;
+    while (severity < LOG_SEVERITIES && name != names[severity]) {
+        severity++;
+    }
+    if (severity == LOG_SEVERITIES) {
+        cprintf_error("Severity needs to be message, info, warning or error.");
+        return false;
+    }
+    if (input.size() > 1) {
+        set_log_filter(static_cast<LogSeverity>(severity), input[1].bool_out());
+    }
+    cprintf("Logging %s lines is %s. %d lines didn't fit in the log buffer.",
+            names[severity],
+            log_filter(static_cast<LogSeverity>(severity)) ? "ON" : "OFF",
+            log_lines_dropped());
+    return true;
+}
+
+static bool toggle_log_binary(VulpesArgSpan input) {
+    if (input.size() > 0) {
+        set_log_binary(input[0].bool_out());
+    }
+    if (log_binary()) {
+        cprintf("The log is written as binary to vulpes.vlog.");
+    } else {
+        cprintf("The log is written as text to vulpes.log.");
+    }
+    return true;
+}
+
+static bool print_about(VulpesArgSpan input) {
     cprintf("%s", "Vulpes is an extension of Halo Custom Edition's capabilities.");
     cprintf("%s", "Copyright (C) 2019-2020 gbMichelle");
     cprintf("%s", "");
@@ -124,11 +240,59 @@ void init_debug_commands() {
         VulpesArgDef("", true, A_LONG)
     );
 
-    static VulpesCommand cmd_toggle_cprint_budget(
+    static VulpesCommand cmd_toggle_budget_overlay(
         "v_dev_show_budget",
-        &toggle_cprint_budget, 0, 1,
+        &toggle_budget_overlay, 0, 2,
+        VulpesArgDef("", true, A_BOOL),
+        VulpesArgDef("sample time", false, A_TIME)
+    );
+
+    static VulpesCommand cmd_tick_profiler(
+        "v_dev_tick_profiler",
+        &toggle_tick_profiler, 0, 1,
+        VulpesArgDef("", true, A_BOOL)
+    );
+    static VulpesCommand cmd_tick_profile(
+        "v_dev_tick_profile",
+        &print_tick_profile, 0, 0
+    );
+    static VulpesCommand cmd_tick_profile_dump(
+        "v_dev_tick_profile_dump",
+        &dump_tick_profile_csv, 0, 0
+    );
+
+#ifdef VULPES_EVENT_TIMING
+    static VulpesCommand cmd_event_timing(
+        "v_dev_event_timing",
+        &toggle_event_timing, 0, 1,
         VulpesArgDef("", true, A_BOOL)
     );
+    static VulpesCommand cmd_event_worst(
+        "v_dev_event_worst",
+        &print_worst_event_handlers, 0, 1,
+        VulpesArgDef("count", false, A_LONG, int64_t(1), int64_t(100))
+    );
+    static VulpesCommand cmd_event_budget(
+        "v_dev_event_budget",
+        &set_event_handler_budget, 0, 3,
+        VulpesArgDef("microseconds", true, A_FLOAT, 0.0f, 1000000.0f),
+        VulpesArgDef("calls in a row", false, A_LONG, int64_t(1), int64_t(10000)),
+        VulpesArgDef("warn/demote/disable", false, A_STRING, 8)
+    );
+#endif
+
+    static VulpesCommand cmd_log_filter(
+        "v_log_filter",
+        &set_log_severity_filter, 0, 2,
+        VulpesArgDef("message/info/warning/error", true, A_STRING),
+        VulpesArgDef("", false, A_BOOL)
+    );
+
+    static VulpesCommand cmd_log_binary(
+        "v_log_binary",
+        &toggle_log_binary, 0, 1,
+        VulpesArgDef("", false, A_BOOL)
+    );
 
     static VulpesCommand cmd_print_about(
         "v_about",
@@ -18,14 +18,17 @@
 #include <algorithm>
 #include <cassert>
 #include <ctype.h>
+#include <cstring>
 #include <exception>
-#include <regex>
+#include <string_view>
 
 #include <vulpes/memory/signatures.hpp>
 #include <vulpes/functions/messaging.hpp>
 #include <vulpes/memory/gamestate/console.hpp>
 
 #include "handler.hpp"
+#include "queue.hpp"
+#include "tokenizer.hpp"
 
 using namespace std;
 
@@ -41,96 +44,129 @@ class VulpesCommandException_UnparsableArg : public exception {
     }
 } unparsable_arg_exception;
 
+// Kept sorted by name so lookups and autocomplete can binary search it.
 static vector<VulpesCommand*> commands;
-regex command_split("([^\\s\"]+)|\"([^\"]*)\"|\"([^\"]*)");
+
+// Command names are plain ASCII, so this is all the lowercasing they need.
+static inline int ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : static_cast<unsigned char>(c);
+}
+
+// Compares two command names like strcmp, but ignoring case. With prefix,
+// names that start with a count as equal to it.
+static int compare_name(string_view a, const char* b, bool prefix = false) {
+    for (size_t i = 0; i < a.size(); i++) {
+        int a_c = ascii_lower(a[i]);
+        int b_c = ascii_lower(b[i]);
+        if (a_c != b_c) {
+            return a_c - b_c;
+        }
+    }
+    if (prefix || b[a.size()] == '\0') {
+        return 0;
+    }
+    return -1;
+}
+
+// Returns the first command that isn't sorted before name.
+static vector<VulpesCommand*>::iterator first_command(string_view name, bool prefix) {
+    return lower_bound(commands.begin(), commands.end(), name,
+        [prefix](VulpesCommand* cmd, string_view name) {
+            return compare_name(name, cmd->get_name_chars(), prefix) > 0;
+        });
+}
 
 // Adds Vulpes results to an already constructed autocomplete list.
 __attribute__((cdecl))
 void auto_complete(char* buffer[], uint16_t* current_index) {
     char* input = console_input_globals()->state.edit_text.text;
     if (input && input[0]) {
-        string input_str(input);
+        string_view input_str(input);
 
         uint8_t developer_mode = 0;
         if (sig_developer_mode_level()){
             developer_mode = *sig_developer_mode_level();
         }
 
-
-        int i = 0;
+        // Everything starting with the input is next to each other.
+        auto it = first_command(input_str, true);
         int j = *current_index;
-        while (i < commands.size() && *current_index < 256) {
-            string cmp_str = commands[i]->get_name();
-            if (input_str.size() <= cmp_str.size()) {
-                cmp_str.resize(input_str.size());
-                if (input_str == cmp_str
-                && developer_mode >= commands[i]->get_dev_level()) {
-                    buffer[j] = commands[i]->get_name_chars();
-                    j++;
-                }
+        while (it != commands.end() && j < 256
+        && compare_name(input_str, (*it)->get_name_chars(), true) == 0) {
+            if (developer_mode >= (*it)->get_dev_level()) {
+                buffer[j] = (*it)->get_name_chars();
+                j++;
             }
-            i++;
+            it++;
         }
         *current_index = j;
     }
 }
 
-// Returns false if the original Halo function should not fire after this.
-__attribute__((cdecl))
-bool process_command(char* input) {
-    string input_str(input);
-    // A line starting with this should be ignored.
-    if(input_str.find(";") == 0) {
-        return false;
+VulpesCommand* find_command(string_view name) {
+    auto it = first_command(name, false);
+    if (it != commands.end() && compare_name(name, (*it)->get_name_chars()) == 0) {
+        return *it;
     }
-    if(input_str.find("#") == 0) {
-        return false;
-    }
-    if(input_str.find("//") == 0) {
-        return false;
+    return NULL;
+}
+
+// Parses the rest of the line as the arguments for command, and runs it.
+static void run_command(VulpesCommand* command, CommandTokenizer* tokens) {
+    // Everything is counted so too many args can be reported, but we
+    // never need to keep more than a command can take.
+    string_view matches[MAX_COMMAND_ARGS];
+    size_t match_count = 0;
+    string_view token;
+    while (tokens->next(&token)) {
+        if (match_count < MAX_COMMAND_ARGS) {
+            matches[match_count] = token;
+        }
+        match_count++;
     }
 
-    vector<string> matches;
+    VulpesArg parsed_args[MAX_COMMAND_ARGS];
+    size_t parsed_count;
+    bool success = true;
+    try {
+        parsed_count = command->parse_args(matches, match_count,
+                                           parsed_args, &success);
+    }catch (exception& e) {
+        cprintf_error("Couldn't parse command. %s", e.what());
+        return;
+    }
+    if (success) {
+        command->execute(VulpesArgSpan(parsed_args, parsed_count));
+    }
+}
 
-    smatch arg_match;
-    string::const_iterator search_start(input_str.cbegin());
-    while(regex_search(search_start, input_str.cend(), arg_match, command_split)) {
-        if(arg_match[1] != "") {
-            string str = arg_match[1];
-            int semicolon_pos = str.find(";");
-            if (semicolon_pos != string::npos) {
-                if (semicolon_pos > 0) {
-                    matches.push_back(str.substr(0, semicolon_pos));
-                }
-                break; // We shouldn't match anything after a semicolon
-            }
-            matches.push_back(str);
-        } else if(arg_match[2] != "") {
-            matches.push_back(arg_match[2]);
-        } else if(arg_match[3] != "") {
-            matches.push_back(arg_match[3]);
-        } else {
-            matches.push_back("");
+void run_command_line(const char* line) {
+    CommandTokenizer tokens(line);
+    string_view token;
+    if (tokens.next(&token)) {
+        VulpesCommand* command = find_command(token);
+        if (command) {
+            run_command(command, &tokens);
         }
-        search_start = arg_match.suffix().first;
     }
+}
 
-    string cmd_to_find = matches[0];
-    matches.erase(matches.begin());
-    transform(cmd_to_find.begin(), cmd_to_find.end(), cmd_to_find.begin(), ::tolower);
-
-    VulpesCommand* matching_cmd;
-    bool found_match = false; // this is used because checking if the pointer
-                              // for matching_cmd !=0 has weird behavior.
+// Returns false if the original Halo function should not fire after this.
+__attribute__((cdecl))
+bool process_command(char* input) {
+    if (is_command_comment(input)) {
+        return false;
+    }
 
-    for (int i=0; i<commands.size(); i++) {
-        if (commands[i]->get_name() == cmd_to_find) {
-            matching_cmd = commands[i];
-            found_match = true;
-            break;
-        }
+    CommandTokenizer tokens(input);
+    string_view token;
+    if (!tokens.next(&token)) {
+        return true;
     }
-    if (found_match) {
+
+    // Anything that isn't ours goes to Halo without any more work.
+    VulpesCommand* matching_cmd = find_command(token);
+    if (matching_cmd) {
         // Log this command.
         ConsoleInputGlobals* input_globals = console_input_globals();
         if (input_globals->history.inputs_saved < 8) input_globals->history.inputs_saved++;
@@ -138,16 +174,9 @@ bool process_command(char* input) {
         input_globals->history.current_id = i;
         strncpy(input_globals->history.entries[i], input, 254);
 
-        vector<VulpesArg> parsed_args;
-        bool success = true;
-        try {
-            parsed_args = matching_cmd->parse_args(matches, &success);
-        }catch (exception& e) {
-            cprintf_error("Couldn't parse command. %s", e.what());
-            return false;
-        }
-        if (success) {
-            matching_cmd->execute(parsed_args);
+        // While the game is ticking commands wait their turn after a tick.
+        if (!queue_command(input)) {
+            run_command(matching_cmd, &tokens);
         }
         return false;
     }
@@ -223,35 +252,56 @@ VulpesArgDef::VulpesArgDef(string arg_name, bool required, VulpesArgType arg_typ
     set_display_name();
 }
 
-string VulpesArgDef::parse_str(string input) {
+string_view VulpesArgDef::parse_str(string_view input) const {
     if (max_characters && input.size() > max_characters) {
         return input.substr(0, max_characters);
     }
     return input;
 }
 
-int64_t parse_to_integer(string input, char** leftover) {
+// strtol and strtof need a terminated string. Anything that doesn't fit in
+// the buffer is too long to be a number we want anyway.
+static bool copy_number(string_view input, char* buffer, size_t buffer_size) {
+    if (input.size() >= buffer_size) {
+        return false;
+    }
+    memcpy(buffer, input.data(), input.size());
+    buffer[input.size()] = '\0';
+    return true;
+}
+
+static const size_t NUMBER_CHARS = 64;
+
+int64_t parse_to_integer(string_view input, bool* success) {
+    char buffer[NUMBER_CHARS];
+    if (!copy_number(input, buffer, NUMBER_CHARS)) {
+        *success = false;
+        return 0;
+    }
+    char* leftover;
     int64_t output;
-    if(input.find("0x") == 0) {
-        output = strtol(input.substr(2, input.size()).data(), leftover, 16);
+    if(input.substr(0, 2) == "0x") {
+        output = strtol(&buffer[2], &leftover, 16);
     } else {
-        output = strtol(input.data(), leftover, 10);
+        output = strtol(buffer, &leftover, 10);
+    }
+    if (*leftover != '\0') {
+        *success = false;
     }
     return output;
 }
 
-int32_t VulpesArgDef::parse_int(string input, char** leftover) {
+int32_t VulpesArgDef::clamp_int(int64_t parsed) const {
     int32_t output;
-    int64_t parsed = parse_to_integer(input, leftover);
     if(parsed > imax) {
-        cprintf_error("Input for arg %s too high. Highest allowed: %d, got %d.",
+        cprintf_error("Input for arg %s too high. Highest allowed: %lld, got %lld.",
                       name.data(), imax, parsed);
-        cprintf_error("Setting it to %d.", imax);
+        cprintf_error("Setting it to %lld.", imax);
         output = imax;
     } else if(parsed < imin) {
-        cprintf_error("Input for arg %s too low. Lowest allowed: %d, got %d.",
+        cprintf_error("Input for arg %s too low. Lowest allowed: %lld, got %lld.",
                       name.data(), imin, parsed);
-        cprintf_error("Setting it to %d.", imax);
+        cprintf_error("Setting it to %lld.", imin);
         output = imin;
     } else {
         output = static_cast<int32_t>(parsed);
@@ -259,8 +309,21 @@ int32_t VulpesArgDef::parse_int(string input, char** leftover) {
     return output;
 }
 
-float VulpesArgDef::parse_flt(string input, char** leftover) {
-    float output = strtof(input.data(), leftover);
+int32_t VulpesArgDef::parse_int(string_view input, bool* success) const {
+    return clamp_int(parse_to_integer(input, success));
+}
+
+float VulpesArgDef::parse_flt(string_view input, bool* success) const {
+    char buffer[NUMBER_CHARS];
+    if (!copy_number(input, buffer, NUMBER_CHARS)) {
+        *success = false;
+        return 0.0;
+    }
+    char* leftover;
+    float output = strtof(buffer, &leftover);
+    if (*leftover != '\0') {
+        *success = false;
+    }
     if(output > fmax) {
         cprintf_error("Input for arg %s too high. Highest allowed: %f, got %f.",
                       name.data(), fmax, output);
@@ -269,22 +332,33 @@ float VulpesArgDef::parse_flt(string input, char** leftover) {
     } else if(output < fmin) {
         cprintf_error("Input for arg %s too low. Lowest allowed: %f, got %f.",
                       name.data(), fmin, output);
-        cprintf_error("Setting it to %f.", fmax);
+        cprintf_error("Setting it to %f.", fmin);
         output = fmin;
     }
     return output;
 }
 
-bool VulpesArgDef::parse_bool(string input) {
-    string parsed = input;
-    transform(parsed.begin(), parsed.end(), parsed.begin(), ::tolower);
-    if (input == "yes" || input == "on" || input == "true" || input == "1") {
+// Compares input to a lowercase word, ignoring the case of input.
+static bool equals_lower(string_view input, const char* word) {
+    size_t i = 0;
+    for (; i < input.size(); i++) {
+        if (ascii_lower(input[i]) != word[i]) {
+            return false;
+        }
+    }
+    return word[i] == '\0';
+}
+
+bool VulpesArgDef::parse_bool(string_view input) const {
+    if (equals_lower(input, "yes") || equals_lower(input, "on")
+    ||  equals_lower(input, "true") || input == "1") {
         return true;
-    } else if (input == "no" || input == "off" || input == "false" || input == "0") {
+    } else if (equals_lower(input, "no") || equals_lower(input, "off")
+           ||  equals_lower(input, "false") || input == "0") {
         return false;
     } else {
-        cprintf_error("Couldn't parse input \"%s\" for %s. Assuming false.",
-                      input.data(), name.data());
+        cprintf_error("Couldn't parse input \"%.*s\" for %s. Assuming false.",
+                      static_cast<int>(input.size()), input.data(), name.data());
         return false;
     }
 }
@@ -298,144 +372,205 @@ enum class Time {
     TBD
 };
 
-regex time_split("([\\d:]+)\\s*([a-zA-Z]+)");
-regex colon_split("([^:]+)");
+static bool parse_time_unit(string_view unit_name, Time* unit) {
+    if (equals_lower(unit_name, "t") || equals_lower(unit_name, "tick")
+    ||  equals_lower(unit_name, "ticks")) {
+        *unit = Time::TICKS;
+    } else if (equals_lower(unit_name, "s") || equals_lower(unit_name, "sec")
+           ||  equals_lower(unit_name, "secs") || equals_lower(unit_name, "second")
+           ||  equals_lower(unit_name, "seconds")) {
+        *unit = Time::SECONDS;
+    } else if (equals_lower(unit_name, "m") || equals_lower(unit_name, "min")
+           ||  equals_lower(unit_name, "mins") || equals_lower(unit_name, "minute")
+           ||  equals_lower(unit_name, "minutes")) {
+        *unit = Time::MINUTES;
+    } else if (equals_lower(unit_name, "h") || equals_lower(unit_name, "hour")
+           ||  equals_lower(unit_name, "hours")) {
+        *unit = Time::HOURS;
+    } else if (equals_lower(unit_name, "d") || equals_lower(unit_name, "day")
+           ||  equals_lower(unit_name, "days")) {
+        *unit = Time::DAYS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool is_digit(char c) {
+    return isdigit(static_cast<unsigned char>(c));
+}
 
-int VulpesArgDef::parse_time(string input, bool* success) {
+static bool is_time_number(char c) {
+    return is_digit(c) || c == ':';
+}
+
+// Reads the number at the start of input the way strtol would.
+static int64_t leading_integer(string_view input) {
+    size_t i = 0;
+    while (i < input.size() && isspace(static_cast<unsigned char>(input[i]))) i++;
+    bool negative = false;
+    if (i < input.size() && (input[i] == '-' || input[i] == '+')) {
+        negative = input[i] == '-';
+        i++;
+    }
     int64_t output = 0;
+    while (i < input.size() && is_digit(input[i]) && output < 2147483647) {
+        output = output * 10 + (input[i] - '0');
+        i++;
+    }
+    return negative ? -output : output;
+}
+
+// Counts the numbers in a group like 1:30.
+static size_t count_time_numbers(string_view numbers) {
+    size_t count = 0;
+    for (size_t i = 0; i < numbers.size(); i++) {
+        if (numbers[i] != ':' && (i == 0 || numbers[i-1] == ':')) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Adds a group like 1:30 to output. The first number is in unit, every
+// number after is in the unit below the one before it.
+static void add_time_numbers(string_view numbers, Time unit, int64_t* output) {
+    size_t i = 0;
+    while (i < numbers.size()) {
+        if (numbers[i] == ':') {
+            i++;
+            continue;
+        }
+        size_t end = numbers.find(':', i);
+        if (end == string_view::npos) {
+            end = numbers.size();
+        }
+        int64_t number = leading_integer(numbers.substr(i, end - i));
+        i = end;
+
+        // Lower the unit for the next parse.
+        switch (unit) {
+            case Time::DAYS :
+                *output += number * 24 * 60 * 60 * 30;
+                unit = Time::HOURS;
+                break;
+            case Time::HOURS :
+                *output += number * 60 * 60 * 30;
+                unit = Time::MINUTES;
+                break;
+            case Time::MINUTES :
+                *output += number * 60 * 30;
+                unit = Time::SECONDS;
+                break;
+            case Time::SECONDS :
+                *output += number * 30;
+                unit = Time::TICKS;
+                break;
+            case Time::TICKS :
+            case Time::TBD :
+                *output += number;
+                break;
+        }
+    }
+}
+
+int VulpesArgDef::parse_time(string_view input, bool* success) const {
+    int64_t output = 0;
+    int length = static_cast<int>(input.size());
 
     // Check if we got anything parsable.
-    const char* input_a = input.data();
     bool has_alpha_chars = false;
     bool has_digit_chars = false;
-    int i = 0;
-    while (input_a[i]) {
-        if (isalpha(input_a[i])) {
+    for (size_t i = 0; i < input.size(); i++) {
+        if (isalpha(static_cast<unsigned char>(input[i]))) {
             has_alpha_chars = true;
-        } else if (isdigit(input_a[i])) {
+        } else if (is_digit(input[i])) {
             has_digit_chars = true;
         }
-        i++;
     }
 
     // Throw a fit if our input can't be valid.
     if (!has_digit_chars && !has_alpha_chars) {
-        cprintf_error("Couldn't parse input \"%s\" for %s. What!?",
-                      input.data(), name.data());
+        cprintf_error("Couldn't parse input \"%.*s\" for %s. What!?",
+                      length, input.data(), name.data());
         *success = false;
         return 0;
     } else if (!has_digit_chars) {
-        cprintf_error("Couldn't parse input \"%s\" for %s. Numbers please?",
-                      input.data(), name.data());
+        cprintf_error("Couldn't parse input \"%.*s\" for %s. Numbers please?",
+                      length, input.data(), name.data());
         *success = false;
         return 0;
     }
 
-    // Split the input into numbers and units if we got both digits and alphabetics.
-    vector<string> n;
-    vector<string> a;
-    if (has_alpha_chars && has_digit_chars) {
-        smatch time_match;
-        string::const_iterator search_start(input.cbegin());
-        while(regex_search(search_start, input.cend(), time_match, time_split)) {
-            n.push_back(time_match[1]);
-            a.push_back(time_match[2]);
-
-            search_start = time_match.suffix().first;
-        }
-    } else if (has_digit_chars) {
-        printf("Just digits.");
-        n.push_back(input);
-        a.push_back(string(""));
-    }
-    // Throw more fits if the splitting failed.
-    if (!n.size()) {
-        cprintf_error("Couldn't parse input \"%s\" for %s. I got nothing.",
-                      input.data(), name.data());
-        *success = false;
-        return 0;
-    }
-    // Get all integers in each string in n.
-    vector<vector<int>> n_int;
-    for (i = 0; i < n.size(); i++) {
-        vector<int> numbers;
-        string num_str = n[i];
-        smatch num_match;
-        string::const_iterator search_start(num_str.cbegin());
-        while(regex_search(search_start, num_str.cend(), num_match, colon_split)) {
-            char* dummy;
-            numbers.push_back(strtol(string(num_match[1]).data(), &dummy, 10));
-            search_start = num_match.suffix().first;
-        }
-        n_int.push_back(numbers);
-    }
-    // Turn all our intergers into their appropriate tick counts.
-    for (i = 0; i < n_int.size() && i < a.size(); i++) {
-        transform(a[i].begin(), a[i].end(), a[i].begin(), ::tolower);
+    if (!has_alpha_chars) {
+        // Just digits, how many numbers there are decides the unit.
+        // So 1:30 is a minute and a half.
         Time unit;
-        if (a[i] == "") {
-            if (n_int[i].size() == 1) {
-                unit = Time::SECONDS;
-            } else if(n_int[i].size() == 2) {
-                unit = Time::MINUTES;
-            } else if(n_int[i].size() == 3) {
-                unit = Time::HOURS;
-            } else if(n_int[i].size() == 4) {
-                unit = Time::DAYS;
-            } else {
-                cprintf_error("Couldn't parse input \"%s\" for %s. "
+        switch (count_time_numbers(input)) {
+            case 1 : unit = Time::SECONDS; break;
+            case 2 : unit = Time::MINUTES; break;
+            case 3 : unit = Time::HOURS;   break;
+            case 4 : unit = Time::DAYS;    break;
+            default :
+                cprintf_error("Couldn't parse input \"%.*s\" for %s. "
                               "Too few or too many units.",
-                              input.data(), name.data());
+                              length, input.data(), name.data());
+                *success = false;
+                return 0;
+        }
+        add_time_numbers(input, unit, &output);
+    } else {
+        // Split the input into numbers and the units after them, like 1h30m.
+        // Numbers without a unit are skipped.
+        size_t groups = 0;
+        size_t i = 0;
+        while (i < input.size()) {
+            if (!is_time_number(input[i])) {
+                i++;
+                continue;
+            }
+            size_t numbers_start = i;
+            while (i < input.size() && is_time_number(input[i])) i++;
+            string_view numbers = input.substr(numbers_start, i - numbers_start);
+
+            size_t unit_start = i;
+            while (unit_start < input.size()
+            && isspace(static_cast<unsigned char>(input[unit_start]))) {
+                unit_start++;
+            }
+            size_t unit_end = unit_start;
+            while (unit_end < input.size()
+            && isalpha(static_cast<unsigned char>(input[unit_end]))) {
+                unit_end++;
+            }
+            if (unit_end == unit_start) {
+                continue;
+            }
+            string_view unit_name = input.substr(unit_start, unit_end - unit_start);
+            i = unit_end;
+
+            Time unit;
+            if (!parse_time_unit(unit_name, &unit)) {
+                cprintf_error("Couldn't parse input \"%.*s\" for %s. "
+                              "%.*s is not an accepted time unit.",
+                              length, input.data(), name.data(),
+                              static_cast<int>(unit_name.size()), unit_name.data());
                 *success = false;
                 return 0;
             }
-        } else if (a[i] == "t" || a[i] == "tick" || a[i] == "ticks") {
-            unit = Time::TICKS;
-        } else if (a[i] == "s" || a[i] == "sec" || a[i] == "secs"
-                || a[i] == "second" || a[i] == "seconds") {
-            unit = Time::SECONDS;
-        } else if (a[i] == "s" || a[i] == "sec" || a[i] == "secs"
-                || a[i] == "second" || a[i] == "seconds") {
-            unit = Time::MINUTES;
-        } else if (a[i] == "h" || a[i] == "hour" || a[i] == "hours") {
-            unit = Time::HOURS;
-        } else if (a[i] == "d" || a[i] == "day" || a[i] == "days") {
-            unit = Time::DAYS;
-        } else {
-            cprintf_error("Couldn't parse input \"%s\" for %s. "
-                          "%s is not an accepted time unit.",
-                          input.data(), name.data(), a[i].data());
+            add_time_numbers(numbers, unit, &output);
+            groups++;
+        }
+        // Throw more fits if the splitting failed.
+        if (!groups) {
+            cprintf_error("Couldn't parse input \"%.*s\" for %s. I got nothing.",
+                          length, input.data(), name.data());
             *success = false;
             return 0;
         }
-        vector<int> current_set = n_int[i];
-        for (int j=0; j < current_set.size(); j++) {
-            // Lower the unit for the next parse.
-            switch (unit) {
-                case Time::DAYS :
-                    output += current_set[j] * 24 * 60 * 60 * 30;
-                    unit = Time::HOURS;
-                    break;
-                case Time::HOURS :
-                    output += current_set[j] * 60 * 60 * 30;
-                    unit = Time::MINUTES;
-                    break;
-                case Time::MINUTES :
-                    output += current_set[j] * 60 * 30;
-                    unit = Time::SECONDS;
-                    break;
-                case Time::SECONDS :
-                    output += current_set[j] * 30;
-                    unit = Time::TICKS;
-                    break;
-                case Time::TICKS :
-                    output += current_set[j];
-                    break;
-            }
-        }
     }
     *success = true;
-    return static_cast<int>(output);
+    return clamp_int(output);
 }
 
 void VulpesArgDef::set_display_name() {
@@ -488,75 +623,81 @@ void VulpesArgDef::set_display_name() {
     }
 }
 
-VulpesArg::VulpesArg(VulpesArgDef def, std::string in, bool* success) {
-    definition = &def;
-    input = in;
-    VulpesArgType type = definition->type;
+VulpesArg::VulpesArg(const VulpesArgDef& def, string_view input, bool* success) {
+    VulpesArgType type = def.type;
 
     if (type != A_STRING && input == "") {
         output = false;
         return;
     }
-    char* leftover;
     switch (type) {
-            case A_STRING :
-            strout = definition->parse_str(input);
+        case A_STRING :
+            strout = def.parse_str(input);
             output = true;
             break;
         case A_LONG :
         case A_SHORT :
         case A_CHAR :
-            intout = definition->parse_int(input, &leftover);
+            intout = def.parse_int(input, success);
             output = true;
-            if (*leftover != '\0') {
-                *success = false;
-            }
             break;
         case A_FLOAT :
-            fltout = definition->parse_flt(input, &leftover);
+            fltout = def.parse_flt(input, success);
             output = true;
-            if (*leftover != '\0') {
-                *success = false;
-            }
             break;
         case A_BOOL :
-            boolout = definition->parse_bool(input);
+            boolout = def.parse_bool(input);
             output = true;
             break;
         case A_TIME :
-            intout = definition->parse_time(input, success);
+            intout = def.parse_time(input, success);
             output = true;
             break;
     }
 }
 
-int VulpesArg::int_out() {
+int VulpesArg::int_out() const {
     return intout;
 }
-float VulpesArg::flt_out() {
+float VulpesArg::flt_out() const {
     return fltout;
 }
-bool VulpesArg::bool_out() {
+bool VulpesArg::bool_out() const {
     return boolout;
 }
-string VulpesArg::str_out() {
+string_view VulpesArg::str_out() const {
     return strout;
 }
-int VulpesArg::time_ticks() {
+int VulpesArg::time_ticks() const {
     return intout;
 }
-int VulpesArg::time_seconds() {
+int VulpesArg::time_seconds() const {
     return (intout/30);
 }
-bool VulpesArg::has_output() {
+bool VulpesArg::has_output() const {
     return output;
 }
 
+VulpesArgSpan::VulpesArgSpan(const VulpesArg* args, size_t count) {
+    this->args = args;
+    this->count = count;
+}
+
+size_t VulpesArgSpan::size() const {
+    return count;
+}
+const VulpesArg& VulpesArgSpan::operator[](size_t i) const {
+    assert(i < count);
+    return args[i];
+}
+
 VulpesCommand::VulpesCommand(string cmd_name,
-                             bool (*function_to_exec)(vector<VulpesArg>),
+                             VulpesCommandFunction function_to_exec,
                              uint8_t min_dev_level, int num_args, ...) {
+    assert(num_args <= MAX_COMMAND_ARGS);
     name = cmd_name;
     strncpy(name_chars, name.data(), 63);
+    name_chars[63] = '\0';
     cmd_func = function_to_exec;
     developer_level = min_dev_level;
     va_list va_args;
@@ -565,9 +706,15 @@ VulpesCommand::VulpesCommand(string cmd_name,
         args.push_back(va_arg(va_args, VulpesArgDef));
     }
     va_end(va_args);
-    commands.push_back(this);
+    // Goes after commands with the same name, so the first one keeps winning.
+    auto position = commands.insert(
+        upper_bound(commands.begin(), commands.end(), name_chars,
+            [](const char* name, VulpesCommand* cmd) {
+                return compare_name(name, cmd->get_name_chars()) < 0;
+            }),
+        this);
     printf("Command %s added at index %d\n",
-           commands[commands.size()-1]->get_name().data(), commands.size()-1);
+           name.data(), position - commands.begin());
 }
 
 // Remove command from the command list on destruction.
@@ -575,7 +722,7 @@ VulpesCommand::~VulpesCommand() {
     for (int i=0;i<commands.size();i++) {
         if (commands[i] == this) {
             printf("Removing command %s by erasing index %d which contains: %s\n",
-                   name, i, commands[i]->get_name());
+                   name.data(), i, commands[i]->get_name_chars());
             commands.erase(commands.begin() + i);
             break;
         }
@@ -594,25 +741,26 @@ vector<VulpesArgDef> VulpesCommand::get_arg_defs() {
     return args;
 }
 
-vector<VulpesArg> VulpesCommand::parse_args(vector<string> arg_strings, bool* success) {
+size_t VulpesCommand::parse_args(const string_view* arg_strings, size_t count,
+                                 VulpesArg* parsed, bool* success) {
     int required_args;
     for (required_args = 0; required_args<args.size(); required_args++) {
         if (args[required_args].optional) {
             break;
         }
     }
-    if (arg_strings.size() < required_args) {
+    if (count < required_args) {
         cprintf_error("Too few args for command: %s. Got %d, expected %d to %d.",
-                      name.data(), arg_strings.size(), required_args, args.size());
+                      name.data(), count, required_args, args.size());
         throw wrong_arg_count_exception;
-    } else if (arg_strings.size() > args.size()) {
+    } else if (count > args.size()) {
         cprintf_error("Too many args for command: %s. Got %d, expected %d to %d.",
-                      name.data(), arg_strings.size(), required_args, args.size());
+                      name.data(), count, required_args, args.size());
         throw wrong_arg_count_exception;
     }
-    vector<VulpesArg> parsed_args;
-    for (int i=0; i<arg_strings.size(); i++) {
-        parsed_args.push_back(VulpesArg(args[i], arg_strings[i], success));
+    size_t i;
+    for (i=0; i<count; i++) {
+        parsed[i] = VulpesArg(args[i], arg_strings[i], success);
         if (!*success) {
             cprintf_error("Couldn't parse arg #%d %s",
                           i+1, args[i].display_name.data());
@@ -620,14 +768,14 @@ vector<VulpesArg> VulpesCommand::parse_args(vector<string> arg_strings, bool* su
             break;
         }
     }
-    return parsed_args;
+    return i;
 }
 
 uint8_t VulpesCommand::get_dev_level() {
     return developer_level;
 }
 
-bool VulpesCommand::execute(vector<VulpesArg> parsed_args) {
+bool VulpesCommand::execute(VulpesArgSpan parsed_args) {
     bool success;
     try {
         success = cmd_func(parsed_args);
@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <stdarg.h>
 
 // These functions are and should only be called by the game.
@@ -48,11 +49,11 @@ public:
     VulpesArgDef(std::string arg_name, bool required, VulpesArgType arg_type, int64_t min, int64_t max);
     VulpesArgDef(std::string arg_name, bool required, VulpesArgType arg_type, float min, float max);
 
-    std::string parse_str(std::string input);
-    int32_t parse_int(std::string input, char** leftover);
-    float parse_flt(std::string input, char** leftover);
-    bool parse_bool(std::string input);
-    int parse_time(std::string input, bool* success);
+    std::string_view parse_str(std::string_view input) const;
+    int32_t parse_int(std::string_view input, bool* success) const;
+    float parse_flt(std::string_view input, bool* success) const;
+    bool parse_bool(std::string_view input) const;
+    int parse_time(std::string_view input, bool* success) const;
 
     std::string name;
     std::string display_name;
@@ -63,52 +64,84 @@ public:
     int64_t imin;
     float fmin = -16777216;
     float fmax = 16777216;
-    int max_characters;
+    int max_characters = 0;
 private:
+    int32_t clamp_int(int64_t parsed) const;
     void set_display_name();
 };
 
+// The most arguments a command can take.
+const size_t MAX_COMMAND_ARGS = 8;
+
+// A parsed argument. Strings point into the command line it was parsed from,
+// so an argument can't be kept around after the command is done.
 class VulpesArg {
 public:
-    VulpesArg(VulpesArgDef def, std::string in, bool* success);
+    VulpesArg() = default;
+    VulpesArg(const VulpesArgDef& def, std::string_view in, bool* success);
 
-    int         int_out();
-    float       flt_out();
-    bool       bool_out();
-    std::string str_out();
-    int      time_ticks();
-    int      time_seconds();
+    int              int_out() const;
+    float            flt_out() const;
+    bool            bool_out() const;
+    std::string_view str_out() const;
+    int           time_ticks() const;
+    int         time_seconds() const;
 
-    bool     has_output();
+    bool     has_output() const;
 
 private:
-    VulpesArgDef* definition;
-    std::string input;
     bool output = false;
 
-    int intout;
-    float fltout;
-    bool boolout;
-    std::string strout;
+    int intout = 0;
+    float fltout = 0.0;
+    bool boolout = false;
+    std::string_view strout;
+};
+
+// The arguments a command was given. These live on the stack of whoever ran
+// the command, so this just points at them.
+class VulpesArgSpan {
+public:
+    VulpesArgSpan(const VulpesArg* args, size_t count);
+
+    size_t size() const;
+    const VulpesArg& operator[](size_t i) const;
+
+private:
+    const VulpesArg* args;
+    size_t count;
 };
 
+typedef bool (*VulpesCommandFunction)(VulpesArgSpan);
+
 class VulpesCommand {
 public:
     VulpesCommand(std::string cmd_name,
-                  bool (*function_to_exec)(std::vector<VulpesArg>),
+                  VulpesCommandFunction function_to_exec,
                   uint8_t min_dev_level, int num_args, ...);
     ~VulpesCommand();
     std::string get_name();
     char* get_name_chars();
     std::vector<VulpesArgDef> get_arg_defs();
-    std::vector<VulpesArg> parse_args(std::vector<std::string> arg_strings, bool* success);
+    // Parses count arg_strings into parsed, which needs room for
+    // MAX_COMMAND_ARGS. Returns how many were parsed.
+    size_t parse_args(const std::string_view* arg_strings, size_t count,
+                      VulpesArg* parsed, bool* success);
     uint8_t get_dev_level();
-    bool execute(std::vector<VulpesArg> parsed_args);
+    bool execute(VulpesArgSpan parsed_args);
 
 private:
     char name_chars[64];
     std::string name;
     std::vector<VulpesArgDef> args;
-    bool (*cmd_func)(std::vector<VulpesArg>);
+    VulpesCommandFunction cmd_func;
     uint8_t developer_level;
 };
+
+// Finds the command with this name, ignoring case. Doesn't allocate, because
+// this runs for every line that goes through the console.
+VulpesCommand* find_command(std::string_view name);
+
+// Runs a line of console input if it is a Vulpes command. This doesn't
+// queue it or log it to the console history like console input is.
+void run_command_line(const char* line);
@@ -0,0 +1,161 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include <vulpes/debug/clock.hpp>
+#include <vulpes/functions/messaging.hpp>
+#include <vulpes/memory/gamestate/console.hpp>
+
+#include "handler.hpp"
+#include "queue.hpp"
+
+struct QueuedCommand {
+    int32_t machine;
+    char line[256];
+};
+
+struct CommandSource {
+    QueuedCommand commands[COMMANDS_QUEUED_PER_SOURCE];
+    size_t first;
+    size_t count;
+
+    // Stats for cprint_command_queue.
+    uint32_t queued;
+    uint32_t dropped;
+    size_t most_waiting;
+};
+
+// Source 0 is everything that isn't an rcon machine, like the local console.
+static const size_t COMMAND_SOURCES = 17;
+static CommandSource sources[COMMAND_SOURCES];
+static size_t next_source = 0;
+static size_t waiting = 0;
+
+static double budget_microseconds = 2000.0;
+static size_t budget_count = 16;
+// Ticks that ran out of budget with commands still waiting.
+static uint32_t ticks_over_budget = 0;
+
+// If no tick has run for this long the game isn't ticking, like in the menus.
+static const double NOT_TICKING_MICROSECONDS = 250000.0;
+static uint64_t last_tick = 0;
+
+static size_t source_of(int32_t machine) {
+    if (machine >= 0 && machine < COMMAND_SOURCES - 1) {
+        return machine + 1;
+    }
+    return 0;
+}
+
+// Takes the next command, going around the sources one at a time.
+static void pop_command(QueuedCommand* out) {
+    while (sources[next_source].count == 0) {
+        next_source = (next_source + 1) % COMMAND_SOURCES;
+    }
+    CommandSource* source = &sources[next_source];
+    *out = source->commands[source->first];
+    source->first = (source->first + 1) % COMMANDS_QUEUED_PER_SOURCE;
+    source->count--;
+    waiting--;
+    next_source = (next_source + 1) % COMMAND_SOURCES;
+}
+
+static void run_queued(const QueuedCommand* queued) {
+    // Halo sends console output to the rcon machine in here.
+    ConsoleGlobals* globals = console_globals();
+    int32_t machine = globals->rcon_machine_id;
+    globals->rcon_machine_id = queued->machine;
+    run_command_line(queued->line);
+    globals->rcon_machine_id = machine;
+}
+
+bool queue_command(const char* line) {
+    if (!last_tick || clock_microseconds(clock_now() - last_tick) > NOT_TICKING_MICROSECONDS) {
+        // Anything left from when the game stopped ticking goes first.
+        QueuedCommand queued;
+        while (waiting) {
+            pop_command(&queued);
+            run_queued(&queued);
+        }
+        return false;
+    }
+
+    int32_t machine = console_globals()->rcon_machine_id;
+    CommandSource* source = &sources[source_of(machine)];
+    if (source->count == COMMANDS_QUEUED_PER_SOURCE) {
+        source->dropped++;
+        cprintf_error("Too many commands waiting, dropped: %s", line);
+        return true;
+    }
+    size_t slot = (source->first + source->count) % COMMANDS_QUEUED_PER_SOURCE;
+    QueuedCommand* queued = &source->commands[slot];
+    queued->machine = machine;
+    strncpy(queued->line, line, sizeof(queued->line) - 1);
+    queued->line[sizeof(queued->line) - 1] = '\0';
+
+    source->count++;
+    source->queued++;
+    if (source->count > source->most_waiting) {
+        source->most_waiting = source->count;
+    }
+    waiting++;
+    return true;
+}
+
+void run_queued_commands() {
+    uint64_t start = clock_now();
+    last_tick = start;
+
+    size_t ran = 0;
+    QueuedCommand queued;
+    while (waiting) {
+        if (ran > 0 && (ran >= budget_count
+        || clock_microseconds(clock_now() - start) >= budget_microseconds)) {
+            ticks_over_budget++;
+            break;
+        }
+        pop_command(&queued);
+        run_queued(&queued);
+        ran++;
+    }
+}
+
+void set_command_budget(double microseconds, size_t count) {
+    budget_microseconds = microseconds;
+    budget_count = count;
+}
+
+void cprint_command_queue() {
+    cprintf("Commands get %.0f us and %d commands per tick. %d waiting.",
+            budget_microseconds, budget_count, waiting);
+    cprintf("%d ticks ran out of budget with commands waiting.", ticks_over_budget);
+    for (size_t i = 0; i < COMMAND_SOURCES; i++) {
+        const CommandSource* source = &sources[i];
+        if (!source->queued && !source->dropped) {
+            continue;
+        }
+        if (i == 0) {
+            cprintf("console: %d queued, %d dropped, at most %d waiting.",
+                    source->queued, source->dropped, source->most_waiting);
+        } else {
+            cprintf("rcon machine %d: %d queued, %d dropped, at most %d waiting.",
+                    i - 1, source->queued, source->dropped, source->most_waiting);
+        }
+    }
+}
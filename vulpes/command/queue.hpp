@@ -0,0 +1,45 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+
+// While the game is ticking, Vulpes commands from the console and rcon don't
+// run the moment they come in. They are queued and run after a tick, within
+// a time and count budget, so a flood of them can't make a tick late.
+//
+// The local console and every rcon machine have their own queue, and they
+// take turns, so one busy source can't hold up the others. Queued commands
+// run as if they came from their source, so rcon output still goes back to
+// whoever sent the command.
+
+// How many commands a single source can have waiting. More are dropped.
+const size_t COMMANDS_QUEUED_PER_SOURCE = 16;
+
+// Queues a line that starts with a Vulpes command. Returns false if it
+// should run right away instead, because the game isn't ticking.
+bool queue_command(const char* line);
+
+// Called by the tick hook.
+void run_queued_commands();
+
+// How long and how many commands run_queued_commands gets each tick.
+// At least one command runs every tick, however long it takes.
+void set_command_budget(double microseconds, size_t count);
+
+void cprint_command_queue();
@@ -0,0 +1,241 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cctype>
+#include <cstdio>
+#include <exception>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include <util/file_helpers.hpp>
+#include <vulpes/functions/messaging.hpp>
+#include <vulpes/hooks/map.hpp>
+#include <vulpes/memory/global.hpp>
+#include <vulpes/paths.hpp>
+#include <vulpes/timers.hpp>
+
+#include "script.hpp"
+#include "tokenizer.hpp"
+
+bool CommandScript::load(const char* path) {
+    // The running commands would lose their arguments.
+    if (running) {
+        cprintf_error("Can't reload %s while it is running.", path);
+        return true;
+    }
+    steps.clear();
+    args.clear();
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    text.assign(file_get_size(f) + 1, '\0');
+    file_read_into_buffer(text.data(), f);
+    fclose(f);
+
+    // Split the lines in place, so each one ends like console input does.
+    size_t line_start = 0;
+    int line_number = 0;
+    while (line_start < text.size() - 1) {
+        size_t line_end = line_start;
+        while (text[line_end] != '\n' && text[line_end] != '\0') {
+            line_end++;
+        }
+        text[line_end] = '\0';
+        char* line = &text[line_start];
+        line_start = line_end + 1;
+        line_number++;
+
+        // Skip empty lines and comments.
+        while (isspace(static_cast<unsigned char>(*line))) line++;
+        if (line[0] == '\0' || line[0] == ';' || line[0] == '#'
+        || (line[0] == '/' && line[1] == '/')) {
+            continue;
+        }
+
+        CommandTokenizer tokens(line);
+        std::string_view token;
+        if (!tokens.next(&token)) {
+            continue;
+        }
+        VulpesCommand* command = find_command(token);
+        if (!command) {
+            cprintf_error("%s:%d: %.*s is not a Vulpes command.", path,
+                          line_number, static_cast<int>(token.size()), token.data());
+            continue;
+        }
+
+        std::string_view matches[MAX_COMMAND_ARGS];
+        size_t match_count = 0;
+        while (tokens.next(&token)) {
+            if (match_count < MAX_COMMAND_ARGS) {
+                matches[match_count] = token;
+            }
+            match_count++;
+        }
+
+        Step step;
+        step.command = command;
+        step.first_arg = args.size();
+        args.resize(args.size() + MAX_COMMAND_ARGS);
+        bool success = true;
+        try {
+            step.arg_count = command->parse_args(matches, match_count,
+                                                 &args[step.first_arg], &success);
+        } catch (std::exception& e) {
+            success = false;
+        }
+        args.resize(step.first_arg + (success ? step.arg_count : 0));
+        if (!success) {
+            cprintf_error("%s:%d: Couldn't parse command.", path, line_number);
+            continue;
+        }
+        steps.push_back(step);
+    }
+    return true;
+}
+
+void CommandScript::run() {
+    // A script that runs itself would never stop.
+    if (running) {
+        cprintf_error("A command script tried to run itself.");
+        return;
+    }
+    running = true;
+    for (size_t i = 0; i < steps.size(); i++) {
+        const Step& step = steps[i];
+        step.command->execute(VulpesArgSpan(&args[step.first_arg], step.arg_count));
+    }
+    running = false;
+}
+
+size_t CommandScript::size() {
+    return steps.size();
+}
+
+// Loaded scripts by name. Map nodes don't move, so timers can point at them.
+static std::map<std::string, CommandScript> scripts;
+
+static std::string script_path(std::string_view name) {
+    return std::string(profile_path()) + SCRIPT_PATH + "\\"
+         + std::string(name) + ".txt";
+}
+
+// Gets a script, loading it the first time it is asked for.
+static CommandScript* get_script(std::string_view name, bool quiet) {
+    auto found = scripts.find(std::string(name));
+    if (found != scripts.end()) {
+        return &found->second;
+    }
+    auto path = script_path(name);
+    CommandScript* script = &scripts[std::string(name)];
+    if (!script->load(path.data())) {
+        if (!quiet) {
+            cprintf_error("Couldn't read %s", path.data());
+        }
+        scripts.erase(std::string(name));
+        return NULL;
+    }
+    return script;
+}
+
+static void run_script_timer(TimerHandle timer, void* script) {
+    reinterpret_cast<CommandScript*>(script)->run();
+}
+
+static std::map<std::string, TimerHandle> repeating_scripts;
+
+static void run_map_load_script() {
+    // Make the folder once, so people know where scripts go.
+    static bool made_dir = false;
+    if (!made_dir) {
+        make_dir(std::string(profile_path()) + VULPES_PATH);
+        make_dir(std::string(profile_path()) + SCRIPT_PATH);
+        made_dir = true;
+    }
+    // Most servers won't have one, so stay quiet about it.
+    CommandScript* script = get_script("map_load_mp", true);
+    if (script) {
+        script->run();
+    }
+}
+
+static bool run_script(VulpesArgSpan input) {
+    CommandScript* script = get_script(input[0].str_out(), false);
+    if (!script) {
+        return false;
+    }
+    if (input.size() > 1 && input[1].time_ticks() > 0) {
+        timer_after(input[1].time_ticks(), &run_script_timer, script);
+    } else {
+        script->run();
+    }
+    return true;
+}
+
+static bool run_script_every(VulpesArgSpan input) {
+    std::string name(input[0].str_out());
+    auto repeating = repeating_scripts.find(name);
+    if (repeating != repeating_scripts.end()) {
+        timer_cancel(repeating->second);
+        repeating_scripts.erase(repeating);
+    }
+    if (input.size() < 2 || input[1].time_ticks() <= 0) {
+        cprintf("Script %s stopped repeating.", name.data());
+        return true;
+    }
+    CommandScript* script = get_script(name, false);
+    if (!script) {
+        return false;
+    }
+    repeating_scripts[name] = timer_every(input[1].time_ticks(), &run_script_timer, script);
+    return true;
+}
+
+static bool reload_scripts(VulpesArgSpan input) {
+    // Reload in place, timers still point at these.
+    for (auto& script : scripts) {
+        auto path = script_path(script.first);
+        if (!script.second.load(path.data())) {
+            cprintf_error("Couldn't read %s, it won't run anymore.", path.data());
+        }
+    }
+    cprintf("Reloaded %d scripts.", scripts.size());
+    return true;
+}
+
+void init_script_commands() {
+    static VulpesCommand cmd_script_run(
+        "v_script_run",
+        &run_script, 0, 2,
+        VulpesArgDef("name", true, A_STRING),
+        VulpesArgDef("delay", false, A_TIME)
+    );
+    static VulpesCommand cmd_script_every(
+        "v_script_every",
+        &run_script_every, 0, 2,
+        VulpesArgDef("name", true, A_STRING),
+        VulpesArgDef("interval", false, A_TIME)
+    );
+    static VulpesCommand cmd_script_reload(
+        "v_script_reload",
+        &reload_scripts, 0, 0
+    );
+
+    ADD_CALLBACK(EVENT_MAP_LOAD_MP, run_map_load_script);
+}
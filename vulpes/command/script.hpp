@@ -0,0 +1,62 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "handler.hpp"
+
+// A file of Vulpes commands that is parsed once, so running it again skips
+// all the tokenizing and argument checking the console would do.
+//
+// Lines are read like console input, one command per line. Lines that
+// aren't Vulpes commands, or have bad arguments, are reported when the file
+// is loaded and left out.
+class CommandScript {
+public:
+    CommandScript() = default;
+    CommandScript(const CommandScript&) = delete;
+
+    // Loads and parses the file at path, replacing what was loaded before.
+    // Returns false if the file couldn't be read.
+    bool load(const char* path);
+
+    // Runs every command in order.
+    void run();
+
+    // How many commands will run.
+    size_t size();
+
+private:
+    struct Step {
+        VulpesCommand* command;
+        size_t first_arg;
+        size_t arg_count;
+    };
+
+    // The parsed arguments point into this, so it never changes after load.
+    std::vector<char> text;
+    std::vector<VulpesArg> args;
+    std::vector<Step> steps;
+    bool running = false;
+};
+
+// Scripts go in SCRIPT_PATH in the profile directory, as <name>.txt.
+// The map_load_mp script runs whenever a multiplayer map loads.
+void init_script_commands();
@@ -19,15 +19,18 @@
 #include <vulpes/functions/messaging.hpp>
 #include <vulpes/memory/gamestate/network.hpp>
 #include <vulpes/memory/gamestate/server/king.hpp>
+#include <vulpes/timers.hpp>
 
 #include "handler.hpp"
+#include "queue.hpp"
 #include "server.hpp"
 
-bool cmd_rprint_func(std::vector<VulpesArg> input) {
+bool cmd_rprint_func(VulpesArgSpan input) {
     if (game_is_server_executable()) {
         int player_id = input[0].int_out();
         if (player_id < 16) {
-            rprintf(player_id, input[1].str_out().data());
+            std::string_view text = input[1].str_out();
+            rprintf(player_id, "%.*s", static_cast<int>(text.size()), text.data());
         } else {
             cprintf_error("Player id: %d is too high.", player_id);
         }
@@ -37,24 +40,39 @@ bool cmd_rprint_func(std::vector<VulpesArg> input) {
     return true;
 }
 
-bool cmd_sv_say_func(std::vector<VulpesArg> input) {
+bool cmd_sv_say_func(VulpesArgSpan input) {
     int player_id = input[0].int_out();
     if (player_id < 16) {
+        std::string_view text = input[1].str_out();
         chatf(HudChatType::SERVER, -1, player_id,
-              "%s", input[1].str_out().data());
+              "%.*s", static_cast<int>(text.size()), text.data());
     } else {
         cprintf_error("Player id: %d is too high.", player_id);
     }
     return true;
 }
 
-bool cmd_sv_hill_move_func(std::vector<VulpesArg> input) {
+static TimerHandle hill_move_timer = 0;
+
+static void move_hill(TimerHandle timer, void* context) {
     king_globals()->current_hill_time_left = 1;
     cprintf("Hill moved.");
+}
+
+bool cmd_sv_hill_move_func(VulpesArgSpan input) {
+    // A new move replaces one that is still waiting.
+    timer_cancel(hill_move_timer);
+    if (input.size() > 0 && input[0].time_ticks() > 0) {
+        int ticks = input[0].time_ticks();
+        hill_move_timer = timer_after(ticks, &move_hill);
+        cprintf("Hill will move in %d seconds.", ticks/30);
+    } else {
+        move_hill(0, NULL);
+    }
     return true;
 }
 
-bool cmd_sv_hill_timer_func(std::vector<VulpesArg> input) {
+bool cmd_sv_hill_timer_func(VulpesArgSpan input) {
     auto king_globs = king_globals_upgrade();
     int32_t ticks = input[0].int_out();
     king_globs->hill_length = ticks;
@@ -67,6 +85,22 @@ bool cmd_sv_hill_timer_func(std::vector<VulpesArg> input) {
     return true;
 }
 
+bool cmd_sv_command_budget_func(VulpesArgSpan input) {
+    float microseconds = input[0].flt_out();
+    size_t count = 16;
+    if (input.size() > 1) {
+        count = input[1].int_out();
+    }
+    set_command_budget(microseconds, count);
+    cprintf("Commands get %.0f us and %d commands per tick.", microseconds, count);
+    return true;
+}
+
+bool cmd_sv_command_queue_func(VulpesArgSpan input) {
+    cprint_command_queue();
+    return true;
+}
+
 void init_server_commands() {
     static VulpesCommand cmd_rprint(
         "v_sv_rprint", &cmd_rprint_func, 0, 2,
@@ -79,11 +113,20 @@ void init_server_commands() {
         VulpesArgDef("text", true, A_STRING)
     );
     static VulpesCommand cmd_sv_hill_move(
-        "v_sv_hill_move", &cmd_sv_hill_move_func, 0, 0
+        "v_sv_hill_move", &cmd_sv_hill_move_func, 0, 1,
+        VulpesArgDef("delay", false, A_TIME)
     );
     static VulpesCommand cmd_sv_hill_timer(
         "v_sv_hill_timer", &cmd_sv_hill_timer_func, 0, 2,
         VulpesArgDef("time", true, A_TIME),
         VulpesArgDef("reset_timer", false, A_BOOL)
     );
+    static VulpesCommand cmd_sv_command_budget(
+        "v_sv_command_budget", &cmd_sv_command_budget_func, 0, 2,
+        VulpesArgDef("microseconds", true, A_FLOAT, 0.0f, 33000.0f),
+        VulpesArgDef("commands", false, A_LONG, int64_t(1), int64_t(1000))
+    );
+    static VulpesCommand cmd_sv_command_queue(
+        "v_sv_command_queue", &cmd_sv_command_queue_func, 0, 0
+    );
 }
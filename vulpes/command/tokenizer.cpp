@@ -0,0 +1,68 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cctype>
+#include <cstring>
+
+#include "tokenizer.hpp"
+
+static bool is_space(char c) {
+    return isspace(static_cast<unsigned char>(c));
+}
+
+CommandTokenizer::CommandTokenizer(const char* input) {
+    position = input;
+}
+
+bool CommandTokenizer::next(std::string_view* token) {
+    while (is_space(*position)) position++;
+    if (*position == '\0') return false;
+
+    if (*position == '"') {
+        const char* start = position + 1;
+        const char* end = strchr(start, '"');
+        if (end) {
+            *token = std::string_view(start, end - start);
+            position = end + 1;
+        } else {
+            *token = std::string_view(start);
+            position = start + token->size();
+        }
+        return true;
+    }
+
+    // A word ends at whitespace or at the start of a quoted one.
+    const char* start = position;
+    while (*position && *position != '"' && !is_space(*position)) {
+        if (*position == ';') {
+            // Skip the rest of the line.
+            const char* semicolon = position;
+            position += strlen(position);
+            if (semicolon == start) return false;
+            *token = std::string_view(start, semicolon - start);
+            return true;
+        }
+        position++;
+    }
+    *token = std::string_view(start, position - start);
+    return true;
+}
+
+bool is_command_comment(const char* input) {
+    if (input[0] == ';' || input[0] == '#') return true;
+    return input[0] == '/' && input[1] == '/';
+}
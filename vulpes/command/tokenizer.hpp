@@ -0,0 +1,42 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <string_view>
+
+// Splits a console line into the words of a command without copying it.
+//
+// Words are split on whitespace. "Quoted text" is one word, and a quote that
+// is never closed runs to the end of the line. A semicolon outside of quotes
+// ends the command, nothing after it is read.
+//
+// The tokens point into the input, so it has to outlive them.
+class CommandTokenizer {
+public:
+    CommandTokenizer(const char* input);
+
+    // Puts the next word in token. Returns false if there are no more.
+    bool next(std::string_view* token);
+
+private:
+    const char* position;
+};
+
+// Whether the line is a comment that should be ignored, which is any line
+// that starts with ';', '#' or "//".
+bool is_command_comment(const char* input);
@@ -15,50 +15,172 @@
  * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
  */
 
+#include <algorithm>
+#include <cstdio>
+
 #include <vulpes/functions/messaging.hpp>
+#include <vulpes/memory/gamestate/console.hpp>
+#include <vulpes/memory/gamestate/network.hpp>
 #include <vulpes/memory/gamestate/object/object.hpp>
 #include <vulpes/memory/gamestate/effect.hpp>
 #include <vulpes/network/network_id.hpp>
+#include <vulpes/timers.hpp>
+
+#include "budget.hpp"
+
+#define BUDGET_TEMPLATE "%s:|t% 4d/%d (%d)"
+
+// Two budgets per line, separated by |t.
+static const size_t BUDGET_LINES = 5;
+static const size_t BUDGETS = BUDGET_LINES * 2;
+
+struct Budget {
+    const char* name;
+    int32_t count;
+    int32_t max;
+    int32_t peak;
+};
 
-#define BUDGET_TEMPLATE "%s:|t% 4d/%d"
-
-void cprint_budget() {
-    console_clear();
-    auto objects = object_table();
-    auto wp = weather_particles_table();
-    auto p = particle_table();
-    auto psp = particle_system_particles_table();
-    auto e = effect_table();
-    auto el = effect_locations_table();
-    auto d = decals_table();
-    auto cp = contrail_points_table();
-    auto c = contrail_table();
+struct BudgetLine {
+    MemRef id;
+    // What the line shows right now.
+    int32_t count[2];
+    int32_t peak[2];
+};
+
+static Budget budgets[BUDGETS];
+static BudgetLine lines[BUDGET_LINES];
+static TimerHandle overlay_timer = 0;
+static uint32_t ticks_per_sample = 1;
+static uint32_t ticks_until_sample = 0;
+
+static void sample_budgets() {
+    Table* tables[BUDGETS - 1] = {
+        object_table(), weather_particles_table(),
+        particle_table(), particle_system_particles_table(),
+        effect_table(), effect_locations_table(),
+        decals_table(), contrail_points_table(),
+        contrail_table()
+    };
+    for (size_t i = 0; i < BUDGETS - 1; i++) {
+        budgets[i].name = tables[i]->name;
+        budgets[i].count = tables[i]->count();
+        budgets[i].max = tables[i]->max_elements;
+    }
     auto synced_objs = synced_objects();
+    budgets[BUDGETS - 1].name = "Vanilla network objects";
+    budgets[BUDGETS - 1].count = synced_objs->count;
+    budgets[BUDGETS - 1].max = synced_objs->max_count;
+
+    for (size_t i = 0; i < BUDGETS; i++) {
+        budgets[i].peak = std::max(budgets[i].peak, budgets[i].count);
+    }
+}
 
-    // Print two collumns separated by \t
+static bool line_changed(const BudgetLine& line, size_t first) {
+    for (size_t i = 0; i < 2; i++) {
+        if (line.count[i] != budgets[first + i].count
+        ||  line.peak[i] != budgets[first + i].peak) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    cprintf(BUDGET_TEMPLATE "|t" BUDGET_TEMPLATE,
-        objects->name, objects->count(), objects->max_elements,
-        wp->name, wp->count(), wp->max_elements);
+static void format_line(char* text, size_t size, BudgetLine* line, size_t first) {
+    const Budget& a = budgets[first];
+    const Budget& b = budgets[first + 1];
+    snprintf(text, size, BUDGET_TEMPLATE "|t" BUDGET_TEMPLATE,
+             a.name, a.count, a.max, a.peak,
+             b.name, b.count, b.max, b.peak);
+    for (size_t i = 0; i < 2; i++) {
+        line->count[i] = budgets[first + i].count;
+        line->peak[i] = budgets[first + i].peak;
+    }
+}
 
+// Takes new console lines for all of the overlay, so they stay in order.
+static bool take_lines() {
+    for (size_t i = 0; i < BUDGET_LINES; i++) {
+        ConsoleOutput* output = console_line(lines[i].id);
+        if (output) output->text[0] = '\0';
+    }
+    for (size_t i = 0; i < BUDGET_LINES; i++) {
+        ConsoleOutput* output = console_new_line(&lines[i].id);
+        if (!output) return false;
+        output->color = ARGBFloat(1.0, 0.7, 0.7, 0.7);
+        output->tab_stops = true;
+        format_line(output->text, sizeof(output->text), &lines[i], i * 2);
+    }
+    return true;
+}
 
-    cprintf(BUDGET_TEMPLATE "|t" BUDGET_TEMPLATE,
-        p->name, p->count(), p->max_elements,
-        psp->name, psp->count(), psp->max_elements
-    );
+static void update_overlay(TimerHandle timer, void* context) {
+    if (ticks_until_sample <= 1) {
+        sample_budgets();
+        ticks_until_sample = ticks_per_sample;
+    } else {
+        ticks_until_sample--;
+    }
 
-    cprintf(BUDGET_TEMPLATE "|t" BUDGET_TEMPLATE,
-        e->name, e->count(), e->max_elements,
-        el->name, el->count(), el->max_elements
-    );
+    // A dedicated server has no console to keep lines in, changes get
+    // printed to the terminal instead.
+    if (game_is_server_executable()) {
+        for (size_t i = 0; i < BUDGET_LINES; i++) {
+            if (line_changed(lines[i], i * 2)) {
+                char text[255];
+                format_line(text, sizeof(text), &lines[i], i * 2);
+                cprintf("%s", text);
+            }
+        }
+        return;
+    }
 
-    cprintf(BUDGET_TEMPLATE "|t" BUDGET_TEMPLATE,
-        d->name, d->count(), d->max_elements,
-        cp->name, cp->count(), cp->max_elements
-    );
+    if (!console_globals()->initialized) return;
+
+    // If Halo reused any of our lines for other output, start over at the
+    // bottom of the console.
+    for (size_t i = 0; i < BUDGET_LINES; i++) {
+        if (!console_line(lines[i].id)) {
+            take_lines();
+            return;
+        }
+    }
+    for (size_t i = 0; i < BUDGET_LINES; i++) {
+        ConsoleOutput* output = console_line(lines[i].id);
+        if (line_changed(lines[i], i * 2)) {
+            format_line(output->text, sizeof(output->text), &lines[i], i * 2);
+        }
+        // Keep the line from fading out.
+        output->fade_frames = 0;
+    }
+}
+
+void show_budget_overlay(uint32_t sample_ticks) {
+    hide_budget_overlay();
+    for (size_t i = 0; i < BUDGETS; i++) {
+        budgets[i].peak = 0;
+    }
+    for (size_t i = 0; i < BUDGET_LINES; i++) {
+        lines[i].id.raw = 0xFFFFFFFF;
+        // Makes sure the first update shows everything.
+        lines[i].count[0] = -1;
+    }
+    ticks_per_sample = std::max<uint32_t>(sample_ticks, 1);
+    ticks_until_sample = 0;
+    overlay_timer = timer_every(1, &update_overlay);
+}
+
+void hide_budget_overlay() {
+    if (!timer_cancel(overlay_timer)) return;
+    overlay_timer = 0;
+    if (game_is_server_executable()) return;
+    for (size_t i = 0; i < BUDGET_LINES; i++) {
+        ConsoleOutput* output = console_line(lines[i].id);
+        if (output) output->text[0] = '\0';
+    }
+}
 
-    cprintf(BUDGET_TEMPLATE "|t" BUDGET_TEMPLATE,
-        c->name, c->count(), c->max_elements,
-        "Vanilla network objects", synced_objs->count, synced_objs->max_count
-    );
+bool budget_overlay_shown() {
+    return timer_active(overlay_timer);
 }
@@ -17,5 +17,15 @@
 
 #pragma once
 
-// Print all tracked budgets to the user console.
-void cprint_budget();
+#include <cstdint>
+
+// Shows how full the tables with a budget are, in console lines that stay up
+// to date until the overlay is hidden. Lines only get rewritten when what they
+// show changes.
+//
+// Counting a table means walking all of it, so that only happens every
+// sample_ticks ticks. The highest count seen since the overlay was shown is
+// kept for each table and shown next to it.
+void show_budget_overlay(uint32_t sample_ticks);
+void hide_budget_overlay();
+bool budget_overlay_shown();
@@ -15,27 +15,14 @@
  * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
  */
 
-#include "shared.S"
+#pragma once
 
-.intel_syntax noprefix
+#include <cstdint>
 
-.globl _game_tick_wrapper
-_game_tick_wrapper:
-        cc_before_pass_input _before_tick
+// A high resolution clock for measuring how long things take.
+// Readings are only meaningful compared to each other.
 
-        // No args to push because all args
-        // for this function are in the registers.
-        push [esp+4]
-        call game_tick_actual
-        add esp, 4
+uint64_t clock_now();
 
-        cc_after_no_pass _after_tick
-
-        ret
-    game_tick_actual:
-        push ecx
-        push ebx
-        push 0xFFFFF
-        jmp [_game_tick_actual_jmp]
-
-.att_syntax
+// Converts the difference between two readings to microseconds.
+double clock_microseconds(uint64_t ticks);
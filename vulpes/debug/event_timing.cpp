@@ -0,0 +1,154 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include <vulpes/functions/messaging.hpp>
+#include <vulpes/log.hpp>
+
+#include "event_timing.hpp"
+
+static bool timing_on = false;
+
+static float budget_microseconds = 0;
+static uint32_t budget_calls = 1;
+static EventBudgetAction budget_action = EVENT_BUDGET_WARN;
+
+static std::vector<EventListTiming*>& event_lists() {
+    static std::vector<EventListTiming*> lists;
+    return lists;
+}
+
+EventListTiming::EventListTiming(const char* event_name) {
+    name = event_name;
+    event_lists().push_back(this);
+}
+
+EventListTiming::~EventListTiming() {
+    auto& lists = event_lists();
+    lists.erase(std::remove(lists.begin(), lists.end(), this), lists.end());
+}
+
+static std::vector<EventTimingReport> report_all() {
+    std::vector<EventTimingReport> reports;
+    for (auto list : event_lists()) {
+        list->report(&reports);
+    }
+    return reports;
+}
+
+void set_event_timing(bool on) {
+    // Start over, so old numbers don't get mixed in.
+    for (auto list : event_lists()) {
+        list->total = EventTiming();
+    }
+    for (auto& report : report_all()) {
+        *report.timing = EventTiming();
+    }
+    timing_on = on;
+}
+
+bool event_timing_enabled() {
+    return timing_on;
+}
+
+void set_event_budget(float microseconds, uint32_t calls, EventBudgetAction action) {
+    budget_microseconds = microseconds;
+    budget_calls = calls ? calls : 1;
+    budget_action = action;
+}
+
+void event_timing_record(EventTiming* timing, uint64_t start,
+                         const char* event, uintptr_t handler) {
+    float time = clock_microseconds(clock_now() - start);
+
+    // The first call is the start of the average, the rest slowly move it.
+    if (timing->calls == 0) {
+        timing->average = time;
+    } else {
+        timing->average += (time - timing->average) / 16;
+    }
+    timing->maximum = std::max(timing->maximum, time);
+    timing->calls++;
+
+    if (!handler || budget_microseconds <= 0) return;
+    if (time <= budget_microseconds) {
+        timing->over_budget = 0;
+        return;
+    }
+    if (++timing->over_budget != budget_calls) return;
+
+    switch (budget_action) {
+        case EVENT_BUDGET_WARN:
+            // A handler that hovers around the budget can do this every few
+            // ticks. Only the first time goes to the console, after that it
+            // is logged without formatting anything on the game thread.
+            if (!timing->warned) {
+                timing->warned = true;
+                cprintf_warn("Event handler 0x%X of %s went over budget %d times in a row. "
+                    "Next times are only logged.", handler, event, budget_calls);
+            } else {
+                log_deferred(LOG_WARNING,
+                    "Event handler 0x%X of %s went over budget %d times in a row.",
+                    handler, event, budget_calls);
+            }
+            break;
+        case EVENT_BUDGET_DEMOTE:
+            if (timing->state == EVENT_TIMING_NORMAL) {
+                timing->state = EVENT_TIMING_DEMOTED;
+                cprintf_warn("Event handler 0x%X of %s went over budget, "
+                    "it is now only called every %d times.",
+                    handler, event, EVENT_DEMOTED_INTERVAL);
+            }
+            break;
+        case EVENT_BUDGET_DISABLE:
+            timing->state = EVENT_TIMING_DISABLED;
+            cprintf_warn("Event handler 0x%X of %s went over budget, "
+                "it is no longer called.", handler, event);
+            break;
+    }
+}
+
+void cprint_event_timing(size_t count) {
+    if (!timing_on) {
+        cprintf_warn("Event timing is off. Turn it on with v_dev_event_timing.");
+        return;
+    }
+
+    auto reports = report_all();
+    // Handlers that haven't been called since timing was turned on say nothing.
+    reports.erase(std::remove_if(reports.begin(), reports.end(),
+        [](const EventTimingReport& report) {
+            return report.timing->calls == 0;
+        }), reports.end());
+    count = std::min(count, reports.size());
+    std::partial_sort(reports.begin(), reports.begin() + count, reports.end(),
+        [](const EventTimingReport& a, const EventTimingReport& b) {
+            return a.timing->average > b.timing->average;
+        });
+
+    static const char* states[] = { "", " (demoted)", " (disabled)" };
+    for (size_t i = 0; i < count; i++) {
+        auto& report = reports[i];
+        cprintf("%s 0x%X:|tavg %.1fus max %.1fus calls %d%s|tevent avg %.1fus max %.1fus",
+            report.event, report.handler,
+            report.timing->average, report.timing->maximum,
+            report.timing->calls, states[report.timing->state],
+            report.total->average, report.total->maximum);
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "clock.hpp"
+
+// Timing of event handlers, so we can find out which one makes the game
+// hitch. Only built in if VULPES_EVENT_TIMING is defined, and only does
+// anything while it is turned on.
+
+// What happens to a handler that keeps going over the budget.
+enum EventBudgetAction {
+    // Only tell about it.
+    EVENT_BUDGET_WARN,
+    // Only call it every EVENT_DEMOTED_INTERVAL times.
+    EVENT_BUDGET_DEMOTE,
+    // Stop calling it.
+    EVENT_BUDGET_DISABLE
+};
+
+const uint8_t EVENT_DEMOTED_INTERVAL = 8;
+
+enum EventTimingState : uint8_t {
+    EVENT_TIMING_NORMAL,
+    EVENT_TIMING_DEMOTED,
+    EVENT_TIMING_DISABLED
+};
+
+struct EventTiming {
+    // Rolling average and highest time of a call, in microseconds.
+    float average = 0;
+    float maximum = 0;
+    uint32_t calls = 0;
+    // How many calls in a row went over the budget.
+    uint32_t over_budget = 0;
+    // Whether going over the budget was shown on the console already.
+    bool warned = false;
+    EventTimingState state = EVENT_TIMING_NORMAL;
+    // Calls left to skip while demoted.
+    uint8_t skip = 0;
+};
+
+struct EventTimingReport {
+    const char* event;
+    // The function of the handler, or what calls it if it carries a context.
+    uintptr_t handler;
+    uint32_t subscription;
+    EventTiming* timing;
+    // The timing of the whole event.
+    EventTiming* total;
+};
+
+// Every EventList registers itself here, so its timing can be looked up.
+class EventListTiming {
+public:
+    EventListTiming(const char* event_name);
+    virtual ~EventListTiming();
+
+    const char* name;
+    EventTiming total;
+
+    virtual void report(std::vector<EventTimingReport>* out) = 0;
+};
+
+void set_event_timing(bool on);
+bool event_timing_enabled();
+
+// Handlers that take longer than microseconds for calls times in a row get
+// action applied. A budget of 0 means no budget. Turning timing off or on
+// again gives all handlers another chance.
+void set_event_budget(float microseconds, uint32_t calls, EventBudgetAction action);
+
+// Whether a handler should be called this time.
+static inline bool event_timing_should_call(EventTiming* timing) {
+    switch (timing->state) {
+        case EVENT_TIMING_NORMAL:
+            return true;
+        case EVENT_TIMING_DEMOTED:
+            if (timing->skip) {
+                timing->skip--;
+                return false;
+            }
+            timing->skip = EVENT_DEMOTED_INTERVAL - 1;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Adds a call that began at start. handler is 0 for the event as a whole,
+// those don't have a budget.
+void event_timing_record(EventTiming* timing, uint64_t start,
+                         const char* event, uintptr_t handler);
+
+// Prints the handlers that take the longest on average.
+void cprint_event_timing(size_t count);
@@ -0,0 +1,93 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <algorithm>
+
+#include "histogram.hpp"
+
+LatencyHistogram::LatencyHistogram(size_t window_size) {
+    window.resize(window_size ? window_size : 1);
+}
+
+size_t LatencyHistogram::bucket_of(uint32_t value) {
+    if (value < SUB_BUCKETS) return value;
+    // The highest bit says which power of two, the 4 under it which bucket.
+    size_t power = 31 - __builtin_clz(value);
+    size_t shift = power - 4;
+    return SUB_BUCKETS + (power - 4) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+}
+
+uint32_t LatencyHistogram::bucket_from(size_t bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    size_t shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+    uint32_t mantissa = SUB_BUCKETS + (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+    return mantissa << shift;
+}
+
+uint32_t LatencyHistogram::bucket_to(size_t bucket) {
+    if (bucket == BUCKETS - 1) return UINT32_MAX;
+    return bucket_from(bucket + 1) - 1;
+}
+
+void LatencyHistogram::add(uint32_t value) {
+    if (filled == window.size()) {
+        counts[bucket_of(window[next])]--;
+    } else {
+        filled++;
+    }
+    window[next] = value;
+    counts[bucket_of(value)]++;
+    next = (next + 1) % window.size();
+}
+
+void LatencyHistogram::clear() {
+    std::fill(std::begin(counts), std::end(counts), 0);
+    next = 0;
+    filled = 0;
+}
+
+size_t LatencyHistogram::size() {
+    return filled;
+}
+
+uint32_t LatencyHistogram::percentile(double fraction) {
+    if (filled == 0) return 0;
+    // How many samples need to be at or below the answer.
+    size_t wanted = std::max<size_t>(1, fraction * filled + 0.5);
+    size_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= wanted) return std::min(bucket_to(i), maximum());
+    }
+    return maximum();
+}
+
+uint32_t LatencyHistogram::maximum() {
+    uint32_t highest = 0;
+    for (size_t i = 0; i < filled; i++) {
+        highest = std::max(highest, window[i]);
+    }
+    return highest;
+}
+
+std::vector<LatencyHistogram::Bucket> LatencyHistogram::buckets() {
+    std::vector<Bucket> list;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        if (counts[i]) list.push_back({bucket_from(i), bucket_to(i), counts[i]});
+    }
+    return list;
+}
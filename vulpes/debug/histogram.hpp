@@ -0,0 +1,65 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Counts how long things took over the last window_size samples.
+//
+// Like HdrHistogram, values are sorted into buckets that get wider as
+// values grow, so every bucket is within about 6% of the values in it.
+// Values are in whole microseconds, anything up to 2^32 fits.
+class LatencyHistogram {
+public:
+    LatencyHistogram(size_t window_size);
+
+    void add(uint32_t value);
+    void clear();
+
+    // Samples in the window.
+    size_t size();
+    // The value that fraction of the samples are at or below, rounded up to
+    // the end of its bucket. Like 0.99 for the 99th percentile.
+    uint32_t percentile(double fraction);
+    uint32_t maximum();
+
+    // Every bucket as the values it counts and how many there are.
+    struct Bucket {
+        uint32_t from;
+        uint32_t to;
+        uint32_t count;
+    };
+    std::vector<Bucket> buckets();
+
+private:
+    // 16 buckets per power of two, and the values below 16 each have their own.
+    static const size_t SUB_BUCKETS = 16;
+    static const size_t BUCKETS = SUB_BUCKETS + (32 - 4) * SUB_BUCKETS;
+
+    static size_t bucket_of(uint32_t value);
+    static uint32_t bucket_from(size_t bucket);
+    static uint32_t bucket_to(size_t bucket);
+
+    uint32_t counts[BUCKETS] = {};
+    // The samples themselves, so they can be taken out once they are too old.
+    std::vector<uint32_t> window;
+    size_t next = 0;
+    size_t filled = 0;
+};
@@ -0,0 +1,102 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include <vulpes/functions/messaging.hpp>
+
+#include "clock.hpp"
+#include "histogram.hpp"
+#include "tick_profiler.hpp"
+
+static bool profiler_on = false;
+
+static const char* phase_names[NUM_OF_TICK_PHASES] = {
+    "vulpes pre", "game", "vulpes post", "total"
+};
+
+static LatencyHistogram* phases() {
+    static LatencyHistogram histograms[NUM_OF_TICK_PHASES] = {
+        LatencyHistogram(TICK_PROFILER_WINDOW),
+        LatencyHistogram(TICK_PROFILER_WINDOW),
+        LatencyHistogram(TICK_PROFILER_WINDOW),
+        LatencyHistogram(TICK_PROFILER_WINDOW)
+    };
+    return histograms;
+}
+
+void set_tick_profiler(bool on) {
+    for (size_t i = 0; i < NUM_OF_TICK_PHASES; i++) {
+        phases()[i].clear();
+    }
+    profiler_on = on;
+}
+
+bool tick_profiler_enabled() {
+    return profiler_on;
+}
+
+static uint32_t microseconds(uint64_t start, uint64_t end) {
+    double time = clock_microseconds(end - start);
+    return std::min(time, double(UINT32_MAX));
+}
+
+void tick_profiler_record(uint64_t pre_start, uint64_t pre_end,
+                          uint64_t post_start, uint64_t post_end) {
+    auto histograms = phases();
+    histograms[TICK_PHASE_PRE].add(microseconds(pre_start, pre_end));
+    histograms[TICK_PHASE_GAME].add(microseconds(pre_end, post_start));
+    histograms[TICK_PHASE_POST].add(microseconds(post_start, post_end));
+    histograms[TICK_PHASE_TOTAL].add(microseconds(pre_start, post_end));
+}
+
+void cprint_tick_profile() {
+    if (!profiler_on) {
+        cprintf_warn("The tick profiler is off. Turn it on with v_dev_tick_profiler.");
+        return;
+    }
+    auto histograms = phases();
+    cprintf("Last %d ticks in microseconds:", histograms[TICK_PHASE_TOTAL].size());
+    cprintf("phase|tp50|tp99|tp999|tmax");
+    for (size_t i = 0; i < NUM_OF_TICK_PHASES; i++) {
+        auto& histogram = histograms[i];
+        cprintf("%s|t%d|t%d|t%d|t%d", phase_names[i],
+            histogram.percentile(0.5), histogram.percentile(0.99),
+            histogram.percentile(0.999), histogram.maximum());
+    }
+}
+
+bool dump_tick_profile(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "phase,from_us,to_us,count,percentile\n");
+    auto histograms = phases();
+    for (size_t i = 0; i < NUM_OF_TICK_PHASES; i++) {
+        auto& histogram = histograms[i];
+        size_t seen = 0;
+        for (auto& bucket : histogram.buckets()) {
+            seen += bucket.count;
+            fprintf(file, "%s,%u,%u,%u,%.3f\n", phase_names[i],
+                bucket.from, bucket.to, bucket.count,
+                100.0 * seen / histogram.size());
+        }
+    }
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Splits every tick up into the work we do before it, the game's own tick
+// and the work we do after it, so spikes can be blamed on the right one.
+
+enum TickPhase {
+    TICK_PHASE_PRE,
+    TICK_PHASE_GAME,
+    TICK_PHASE_POST,
+    // All three together.
+    TICK_PHASE_TOTAL,
+    NUM_OF_TICK_PHASES
+};
+
+// How many ticks the numbers are over. A minute.
+const size_t TICK_PROFILER_WINDOW = 30 * 60;
+
+// Turning it on starts over with no ticks.
+void set_tick_profiler(bool on);
+bool tick_profiler_enabled();
+
+// Called by the tick hook, with clock_now() readings.
+void tick_profiler_record(uint64_t pre_start, uint64_t pre_end,
+                          uint64_t post_start, uint64_t post_end);
+
+// Prints p50, p99, p999 and max of every phase to the console.
+void cprint_tick_profile();
+
+// Writes the histograms of every phase to a CSV file. Returns false if the
+// file couldn't be written.
+bool dump_tick_profile(const char* path);
@@ -5,12 +5,28 @@
     Modifications:
         -Added function templates and macros for adding events to Event Holders.
          To avoid needing to rewrite the functions each time.
+        -Replaced the vectors of events with EventList, which keeps them sorted
+         by priority so they can be called without copying.
+        -Events can carry a context or small callable, and are identified by
+         subscriptions.
+        -Added EventQueue, which batches frequent events up for their handlers.
+        -Handlers can be timed when built with VULPES_EVENT_TIMING.
 */
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#ifdef VULPES_EVENT_TIMING
+#include <vulpes/debug/event_timing.hpp>
+#endif
+
 enum EventPriority {
     /// These events are called before the default priority events are called.
     EVENT_PRIORITY_BEFORE,
@@ -28,99 +44,407 @@ enum EventPriority {
 /// This is a function typename that has no arguments and returns nothing.
 typedef void (*event_no_args)();
 
+/// Identifies an added event so it can be removed again. 0 means no event.
+typedef uint32_t EventSubscription;
+
+/// How many bytes of context an event can carry without allocating.
+#define EVENT_INLINE_STORAGE (sizeof(void*) * 2)
+
+/// Splits an event function pointer type up into its return and argument types.
+template <class T>
+struct EventSignature;
+
+template <class R, class ... Args>
+struct EventSignature<R (*)(Args ...)> {
+    /// Calls whatever is in an event's storage.
+    typedef R (*Invoker)(const void *storage, Args ...);
+
+    template<class F>
+    static R invoke(const void *storage, Args ... args) {
+        return (*static_cast<const F *>(storage))(args ...);
+    }
+
+    /// Binds a context to a function that takes it as its first argument.
+    template<class C>
+    struct Bound {
+        R (*function)(C *, Args ...);
+        C *context;
+        R operator()(Args ... args) const {
+            return function(context, args ...);
+        }
+    };
+};
+
 /// This struct is used for events and uses a priority and function pointer.
+///
+/// Instead of a plain function pointer an event can also hold a small
+/// callable, like a function with its context or a lambda with captures.
+/// Those are stored inside of the event itself.
 template <class T>
 struct Event {
-    /// This is the function pointer used by the event.
+    /// This is the function pointer used by the event. Null if it holds a callable.
     T function = nullptr;
 
+    /// Calls the callable in storage, null if the event uses function.
+    typename EventSignature<T>::Invoker invoker = nullptr;
+
     /// This is the priority of the event.
     EventPriority priority = EVENT_PRIORITY_DEFAULT;
 
+    /// The token this event was added under. 0 once the event is removed.
+    EventSubscription subscription = 0;
+
+    alignas(void *) unsigned char storage[EVENT_INLINE_STORAGE];
+
+#ifdef VULPES_EVENT_TIMING
+    EventTiming timing;
+
+    /// What to show as the handler in timing reports.
+    uintptr_t handler_address() const {
+        if(invoker) return reinterpret_cast<uintptr_t>(invoker);
+        return reinterpret_cast<uintptr_t>(function);
+    }
+#endif
+
     Event() {}
     Event(T new_function, EventPriority new_priority = EVENT_PRIORITY_DEFAULT) : function(new_function), priority(new_priority) {}
-    Event(const Event &copy) : function(copy.function), priority(copy.priority) {}
+
+    /// The callable needs to fit in EVENT_INLINE_STORAGE and be trivially copyable, so events can be moved around freely.
+    template<class F>
+    static Event from_callable(const F &callable, EventPriority new_priority = EVENT_PRIORITY_DEFAULT) {
+        static_assert(sizeof(F) <= EVENT_INLINE_STORAGE, "Event callable is too big to store inline.");
+        static_assert(alignof(F) <= alignof(void *), "Event callable needs too much alignment to store inline.");
+        static_assert(std::is_trivially_copyable<F>::value, "Event callables need to be trivially copyable.");
+        Event event;
+        new (event.storage) F(callable);
+        event.invoker = &EventSignature<T>::template invoke<F>;
+        event.priority = new_priority;
+        return event;
+    }
+
+    template<typename ... Args>
+    auto operator()(Args&& ... args) const {
+        // Plain functions are called directly, so they cost nothing extra.
+        if(!invoker) return function(std::forward<Args>(args) ...);
+        return invoker(storage, std::forward<Args>(args) ...);
+    }
 };
 
-/// This function calls events in order.
+/// This holds the events of one hook.
 ///
-/// Functions in the same priority are called based on their order in the events vector.
-template<typename T, typename ... Args>
-static inline void call_in_order(std::vector<Event<T>> events, Args&& ... args) {
-    auto count = events.size();
-    for(typename std::vector<Event<T>>::size_type i=0;i<count;i++) {
-        if(events[i].priority == EVENT_PRIORITY_BEFORE) events[i].function(std::forward<Args>(args) ...);
+/// Events are kept sorted by priority, so calling them is one pass over
+/// contiguous memory and nothing gets copied or allocated.
+///
+/// Events can be added and removed while the list is being called. Events
+/// added then are first called the next time around. Events removed then
+/// aren't called anymore, not even later in the same pass.
+template <class T>
+class EventList
+#ifdef VULPES_EVENT_TIMING
+    : public EventListTiming
+#endif
+{
+public:
+#ifdef VULPES_EVENT_TIMING
+    EventList(const char *name = "unnamed event") : EventListTiming(name) {}
+#else
+    EventList(const char *name = "unnamed event") {}
+#endif
+
+    /// Adds an event behind the others with the same priority. Adding a function that is already in the list returns its existing subscription.
+    EventSubscription add(T function, EventPriority priority = EVENT_PRIORITY_DEFAULT) {
+        for(auto &event : events) {
+            if(event.subscription && !event.invoker && event.function == function) return event.subscription;
+        }
+        for(auto &event : pending) {
+            if(!event.invoker && event.function == function) return event.subscription;
+        }
+        return subscribe(Event<T>(function, priority));
     }
-    for(typename std::vector<Event<T>>::size_type i=0;i<count;i++) {
-        if(events[i].priority == EVENT_PRIORITY_DEFAULT) events[i].function(std::forward<Args>(args) ...);
+
+    /// Adds a function that gets context passed as its first argument.
+    template<class C, class F>
+    EventSubscription add(F function, C *context, EventPriority priority = EVENT_PRIORITY_DEFAULT) {
+        typename EventSignature<T>::template Bound<C> bound = {function, context};
+        return add_callable(bound, priority);
     }
-    for(typename std::vector<Event<T>>::size_type i=0;i<count;i++) {
-        if(events[i].priority == EVENT_PRIORITY_AFTER) events[i].function(std::forward<Args>(args) ...);
+
+    /// Adds a small callable, like a lambda with captures.
+    template<class F>
+    EventSubscription add_callable(const F &callable, EventPriority priority = EVENT_PRIORITY_DEFAULT) {
+        return subscribe(Event<T>::from_callable(callable, priority));
     }
-    for(typename std::vector<Event<T>>::size_type i=0;i<count;i++) {
-        if(events[i].priority == EVENT_PRIORITY_FINAL) events[i].function(std::forward<Args>(args) ...);
+
+    /// Removes an event by the subscription add gave for it.
+    void remove(EventSubscription subscription) {
+        if(!subscription) return;
+        for(size_t i=0;i<pending.size();i++) {
+            if(pending[i].subscription == subscription) {
+                pending.erase(pending.begin() + i);
+                return;
+            }
+        }
+        for(size_t i=0;i<events.size();i++) {
+            if(events[i].subscription == subscription) {
+                if(dispatching) {
+                    // Erasing would shift the events that are still to be called.
+                    events[i].subscription = 0;
+                    removed = true;
+                }
+                else {
+                    events.erase(events.begin() + i);
+                }
+                return;
+            }
+        }
     }
-}
 
-/// This function calls events in order, but the event can be denied by any function. Denying will prevent other events from firing.
+    /// Removes an event that was added as a plain function.
+    void remove(T function) {
+        for(auto &event : pending) {
+            if(!event.invoker && event.function == function) return remove(event.subscription);
+        }
+        for(auto &event : events) {
+            if(event.subscription && !event.invoker && event.function == function) return remove(event.subscription);
+        }
+    }
+
+    /// Whether there is nothing to call. Lets hooks skip work nobody wants.
+    bool empty() const {
+        return events.empty() && pending.empty();
+    }
+
+    /// Calls all events in order of priority.
+    template<typename ... Args>
+    void call(Args&& ... args) {
+        dispatching++;
+#ifdef VULPES_EVENT_TIMING
+        if(event_timing_enabled()) {
+            uint64_t start = clock_now();
+            for(size_t i=0;i<events.size();i++) {
+                if(events[i].subscription) call_timed(events[i], std::forward<Args>(args) ...);
+            }
+            event_timing_record(&total, start, name, 0);
+        }
+        else
+#endif
+        for(size_t i=0;i<events.size();i++) {
+            if(events[i].subscription) events[i](std::forward<Args>(args) ...);
+        }
+        if(--dispatching == 0) settle();
+    }
+
+    /// Calls all events in order of priority, until one of them denies.
+    template<typename ... Args>
+    void call_allow(bool &allow, Args&& ... args) {
+        dispatching++;
+#ifdef VULPES_EVENT_TIMING
+        if(event_timing_enabled()) {
+            uint64_t start = clock_now();
+            for(size_t i=0;i<events.size() && allow;i++) {
+                if(events[i].subscription) call_timed_allow(&allow, events[i], std::forward<Args>(args) ...);
+            }
+            event_timing_record(&total, start, name, 0);
+        }
+        else
+#endif
+        for(size_t i=0;i<events.size() && allow;i++) {
+            if(events[i].subscription) allow = events[i](std::forward<Args>(args) ...);
+        }
+        if(--dispatching == 0) settle();
+    }
+
+#ifdef VULPES_EVENT_TIMING
+    void report(std::vector<EventTimingReport> *out) override {
+        for(auto &event : events) {
+            if(event.subscription) {
+                out->push_back({name, event.handler_address(), event.subscription, &event.timing, &total});
+            }
+        }
+    }
+#endif
+
+private:
+    /// Sorted by priority, events with the same priority are in the order they were added.
+    std::vector<Event<T>> events;
+    /// Events added while the list was being called.
+    std::vector<Event<T>> pending;
+    /// How many calls to this list are running. Events can call their own hook.
+    size_t dispatching = 0;
+    /// Whether events were removed while the list was being called.
+    bool removed = false;
+    /// The subscription the next event gets.
+    EventSubscription next_subscription = 1;
+
+    EventSubscription subscribe(Event<T> event) {
+        event.subscription = next_subscription++;
+        if(dispatching) {
+            pending.push_back(event);
+        }
+        else {
+            insert(event);
+        }
+        return event.subscription;
+    }
+
+    void insert(const Event<T> &event) {
+        auto position = events.begin();
+        while(position != events.end() && position->priority <= event.priority) position++;
+        events.insert(position, event);
+    }
+
+#ifdef VULPES_EVENT_TIMING
+    template<typename ... Args>
+    void call_timed(Event<T> &event, Args&& ... args) {
+        if(!event_timing_should_call(&event.timing)) return;
+        uint64_t start = clock_now();
+        event(std::forward<Args>(args) ...);
+        event_timing_record(&event.timing, start, name, event.handler_address());
+    }
+
+    template<typename ... Args>
+    void call_timed_allow(bool *allow, Event<T> &event, Args&& ... args) {
+        if(!event_timing_should_call(&event.timing)) return;
+        uint64_t start = clock_now();
+        *allow = event(std::forward<Args>(args) ...);
+        event_timing_record(&event.timing, start, name, event.handler_address());
+    }
+#endif
+
+    /// Applies the changes that were made while the list was being called.
+    void settle() {
+        if(removed) {
+            size_t kept = 0;
+            for(size_t i=0;i<events.size();i++) {
+                if(events[i].subscription) events[kept++] = events[i];
+            }
+            events.resize(kept);
+            removed = false;
+        }
+        for(auto &event : pending) {
+            insert(event);
+        }
+        pending.clear();
+    }
+};
+
+/// Collects records of an event that can happen hundreds of times per tick,
+/// so its handlers can get them all in one call instead of one call each.
 ///
-/// Functions in the same priority are called based on their order in the events vector.
-template<typename T, typename ... Args>
-static inline void call_in_order_allow(std::vector<Event<T>> events, bool &allow, Args&& ... args) {
-    auto count = events.size();
-    for(typename std::vector<Event<T>>::size_type i=0;i<count && allow;i++) {
-        if(events[i].priority == EVENT_PRIORITY_BEFORE) allow = events[i].function(std::forward<Args>(args) ...);
+/// The handlers take a pointer to the records and how many there are.
+/// Records are kept in a fixed buffer, when it is full what is in it gets
+/// handed out early. So nothing gets lost and nothing gets allocated.
+template <class Record, size_t capacity>
+class EventQueue {
+    static_assert(std::is_trivially_copyable<Record>::value, "Queued records need to be plain data.");
+public:
+    template<class T>
+    void push(const Record &record, EventList<T> &handlers) {
+        if(count == capacity) {
+            if(flushing) {
+                // A handler of this very queue keeps adding to it.
+                lost++;
+                return;
+            }
+            flush(handlers);
+        }
+        records[count++] = record;
     }
-    for(typename std::vector<Event<T>>::size_type i=0;i<count && allow;i++) {
-        if(events[i].priority == EVENT_PRIORITY_DEFAULT) allow = events[i].function(std::forward<Args>(args) ...);
+
+    /// Hands all records out to the handlers and empties the queue.
+    template<class T>
+    void flush(EventList<T> &handlers) {
+        if(flushing || count == 0) return;
+        flushing = true;
+        size_t handed_out = count;
+        handlers.call(static_cast<const Record *>(records), handed_out);
+        // Records the handlers added themselves go out next time.
+        count -= handed_out;
+        memmove(records, records + handed_out, count * sizeof(Record));
+        flushing = false;
     }
-    for(typename std::vector<Event<T>>::size_type i=0;i<count && allow;i++) {
-        if(events[i].priority == EVENT_PRIORITY_AFTER) allow = events[i].function(std::forward<Args>(args) ...);
+
+    size_t size() const {
+        return count;
     }
-    for(typename std::vector<Event<T>>::size_type i=0;i<count && allow;i++) {
-        if(events[i].priority == EVENT_PRIORITY_FINAL) allow = events[i].function(std::forward<Args>(args) ...);
+
+    /// How many records didn't fit while the queue was being handed out.
+    size_t dropped() const {
+        return lost;
     }
+
+private:
+    Record records[capacity];
+    size_t count = 0;
+    size_t lost = 0;
+    bool flushing = false;
+};
+
+/// This function calls events in order.
+///
+/// Functions in the same priority are called based on the order they were added in.
+template<typename T, typename ... Args>
+static inline void call_in_order(EventList<T> &events, Args&& ... args) {
+    events.call(std::forward<Args>(args) ...);
+}
+
+/// This function calls events in order, but the event can be denied by any function. Denying will prevent other events from firing.
+///
+/// Functions in the same priority are called based on the order they were added in.
+template<typename T, typename ... Args>
+static inline void call_in_order_allow(EventList<T> &events, bool &allow, Args&& ... args) {
+    events.call_allow(allow, std::forward<Args>(args) ...);
 }
 
 /// The general style of Halogen002's event add and remove functions reworked into
 /// templates so that they don't need to be rewritten each time.
 
 template<typename EventsHolder, typename EventFunc>
-static inline void add_event(EventsHolder e_hook(), EventFunc event_function, EventPriority priority = EVENT_PRIORITY_DEFAULT) {
-    EventsHolder events = e_hook();
-    for(size_t i=0;i<events->size();i++) {
-        if((*events)[i].function == event_function) return;
-    }
-    events->emplace_back(event_function, priority);
+static inline EventSubscription add_event(EventsHolder e_hook(), EventFunc event_function, EventPriority priority = EVENT_PRIORITY_DEFAULT) {
+    return e_hook()->add(event_function, priority);
+}
+
+template<typename EventsHolder, typename EventFunc, typename Context>
+static inline EventSubscription add_event(EventsHolder e_hook(), EventFunc event_function, Context *context, EventPriority priority = EVENT_PRIORITY_DEFAULT) {
+    return e_hook()->add(event_function, context, priority);
+}
+
+template<typename EventsHolder, typename Callable>
+static inline EventSubscription add_event_callable(EventsHolder e_hook(), const Callable &callable, EventPriority priority = EVENT_PRIORITY_DEFAULT) {
+    return e_hook()->add_callable(callable, priority);
+}
+
+template<typename EventsHolder>
+static inline void del_event(EventsHolder e_hook(), EventSubscription subscription) {
+    e_hook()->remove(subscription);
 }
 
 template<typename EventsHolder, typename EventFunc>
 static inline void del_event(EventsHolder e_hook(), EventFunc &event_function) {
-    EventsHolder events = e_hook();
-    for(size_t i=0;i<events->size();i++) {
-        if((*events)[i].function == event_function) {
-            events->erase(events->begin() + i);
-            return;
-        }
-    }
+    e_hook()->remove(event_function);
 }
 
 #define ADD_CALLBACK_P(e_hook, event_func, priority) add_event(e_hook ## _list, event_func, priority)
 #define ADD_CALLBACK(e_hook, event_func) add_event(e_hook ## _list, event_func)
+#define ADD_CALLBACK_C(e_hook, event_func, context) add_event(e_hook ## _list, event_func, context)
+#define ADD_CALLBACK_CP(e_hook, event_func, context, priority) add_event(e_hook ## _list, event_func, context, priority)
+#define ADD_CALLBACK_LAMBDA(e_hook, callable) add_event_callable(e_hook ## _list, callable)
+#define ADD_CALLBACK_LAMBDA_P(e_hook, callable, priority) add_event_callable(e_hook ## _list, callable, priority)
+// Removes by function pointer, or by the subscription any of the ADD_ macros return.
 #define DEL_CALLBACK(e_hook, event_func) del_event(e_hook ## _list, event_func)
 
 // Use this one in the header.
 // DEFINE_EVENT_HOOK(hook_identifier, return_type, input types)
 #define DEFINE_EVENT_HOOK(name, return_type, ...)       \
         typedef return_type (*name)(__VA_ARGS__);       \
-        std::vector<Event<name>>* name ## _list()
+        EventList<name>* name ## _list()
 
 // Use this one in the source.
 // Creates a list variable in the current scope that can be used to call all
 // hooked events.
 // DEFINE_EVENT_HOOK_LIST(hook_identifier, list_identifier)
 #define DEFINE_EVENT_HOOK_LIST(name, reference_name)    \
-        static std::vector<Event<name>> reference_name; \
-        std::vector<Event<name>>* name ## _list() {     \
+        static EventList<name> reference_name(#name);   \
+        EventList<name>* name ## _list() {              \
             return &reference_name;                     \
         }
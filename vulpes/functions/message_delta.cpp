@@ -17,50 +17,22 @@
 
 #include <vulpes/memory/signatures.hpp>
 
+#include "thunks.hpp"
+
 #include "message_delta.hpp"
 
 // TODO: Clean up function pointers that are passed to code.
 
 extern "C" {
-    uintptr_t func_mdp_encode_ptr;
     uintptr_t func_mdp_decode_ptr;
-    uintptr_t func_mdp_discard_ptr;
 }
 
 uint32_t mdp_encode_stateless_iterated(
     void* output_buffer, int32_t arg1, MessageDeltaType type,
     uint32_t arg3, void* unencoded_message, uint32_t arg5, uint32_t arg6, uint32_t arg7) {
 
-    uint32_t output_size;
-    int32_t type_int = type;
-    void** ptr_to_ptr = &unencoded_message;
-    asm (
-        "pushad;"
-        "push %8;"
-        "push %7;"
-        "push %6;"
-        "push %5;"
-        "push %4;"
-        "push %3;"
-        "push %2;"
-        "mov edx, 0x7FF8;"
-        "mov eax, %1;"
-        "call [_func_mdp_encode_ptr];"
-        "add esp, 0x1C;"
-        "mov %9, eax;"
-        "popad;"
-        : "+m" (func_mdp_encode_ptr)
-        : "m" (output_buffer),
-          "m" (arg1),
-          "m" (type_int),
-          "m" (arg3),
-          "m" (ptr_to_ptr),
-          "m" (arg5),
-          "m" (arg6),
-          "m" (arg7),
-          "m" (output_size)
-    );
-    return output_size;
+    return call_mdp_encode_stateless_iterated(output_buffer, arg1, type,
+        arg3, &unencoded_message, arg5, arg6, arg7);
 }
 
 uint32_t mdp_encode_stateless_iterated(
@@ -85,20 +57,11 @@ bool mdp_decode_stateless_iterated(void* destination, MessageDeltaHeader* messag
 }
 // Test this
 void mdp_discard_iteration_body(MessageDeltaHeader* message_header) {
-    asm (
-        "pushad;"
-        "mov eax, %1;"
-        "call [_func_mdp_discard_ptr];"
-        "popad;"
-        :
-        : "m" (func_mdp_discard_ptr), "m" (message_header)
-    );
+    call_mdp_discard_iteration_body(message_header);
 }
 
 void init_message_delta_processor() {
-    func_mdp_encode_ptr = sig_func_mdp_decode_stateless_iterated();
     func_mdp_decode_ptr = sig_func_mdp_encode_stateless_iterated();
-    func_mdp_discard_ptr = sig_func_mdp_discard_iteration_body();
 }
 
 extern "C" {
@@ -19,6 +19,7 @@
 #include <cstring>
 #include <string>
 
+#include <vulpes/log.hpp>
 #include <vulpes/memory/gamestate/console.hpp>
 #include <vulpes/memory/signatures.hpp>
 
@@ -26,7 +27,7 @@
 
 typedef uint32_t (*FpReturnsInt)();
 
-ConsoleOutput* console_new_line() {
+ConsoleOutput* console_new_line(MemRef* id) {
     ConsoleGlobals* globals = console_globals();
     static auto console_line_new =
         reinterpret_cast<FpReturnsInt>(sig_func_console_line_new());
@@ -36,12 +37,25 @@ ConsoleOutput* console_new_line() {
     if (line.raw != 0xFFFFFFFF) {
         ConsoleOutput* output = &globals->output->entries[line.id.local];
         output->fade_frames = 0;
+        if (id) *id = line;
         return output;
     } else {
         return NULL;
     }
 }
 
+ConsoleOutput* console_line(MemRef id) {
+    ConsoleOutputTable* table = console_output_table();
+    if (id.raw == 0xFFFFFFFF || id.id.local < 0 || id.id.local >= table->max_elements) {
+        return NULL;
+    }
+    ConsoleOutput* output = &table->entries[id.id.local];
+    if (static_cast<uint16_t>(output->salt) != id.id.salt) {
+        return NULL;
+    }
+    return output;
+}
+
 void console_clear() {
     // This is not the best way to do it. But it serves the purpose.
     // We're nulling out all the first chars so Halo doesn't actually see text!
@@ -53,15 +67,21 @@ void console_clear() {
 
 typedef __attribute__((regparm(1)))void (*ConsoleToTerminalAndNetworkCall)(void*);
 
-void vcprintf(const ARGBFloat& color, const char* format, va_list args) {
+static void console_print(const ARGBFloat& color, LogSeverity severity,
+                          const char* format, va_list args) {
     static auto console_to_terminal_and_network =
         reinterpret_cast<ConsoleToTerminalAndNetworkCall>(
                 sig_func_console_to_terminal_and_network());
+    // Format once, for both the log and the console.
+    char text[255];
+    vsnprintf(&text[0], 255, format, args);
+    log_line(severity, text);
+
     ConsoleGlobals* globals = console_globals();
     if (globals->initialized) {
         ConsoleOutput* output = console_new_line();
         if (output) {
-            vsnprintf(&output->text[0], 255, format, args);
+            memcpy(&output->text[0], &text[0], 255);
             output->color = color;
             output->tab_stops = strstr(output->text, "|t") != NULL;
             if (console_to_terminal_and_network) {
@@ -71,6 +91,10 @@ void vcprintf(const ARGBFloat& color, const char* format, va_list args) {
     }
 }
 
+void vcprintf(const ARGBFloat& color, const char* format, va_list args) {
+    console_print(color, LOG_MESSAGE, format, args);
+}
+
 void cprintf(const ARGBFloat& color, const char* format, ...) {
     va_list args;
     va_start(args, format);
@@ -88,21 +112,21 @@ void cprintf(const char* format, ...) {
 void cprintf_info (const char* format, ...) {
     va_list args;
     va_start(args, format);
-    vcprintf(ARGBFloat(1.0, 0.0, 1.0, 0.0), format, args);
+    console_print(ARGBFloat(1.0, 0.0, 1.0, 0.0), LOG_INFO, format, args);
     va_end(args);
 }
 
 void cprintf_warn (const char* format, ...) {
     va_list args;
     va_start(args, format);
-    vcprintf(ARGBFloat(1.0, 1.0, 0.835, 0.0), format, args);
+    console_print(ARGBFloat(1.0, 1.0, 0.835, 0.0), LOG_WARNING, format, args);
     va_end(args);
 }
 
 void cprintf_error(const char* format, ...) {
     va_list args;
     va_start(args, format);
-    vcprintf(ARGBFloat(1.0, 1.0, 0.0, 0.0), format, args);
+    console_print(ARGBFloat(1.0, 1.0, 0.0, 0.0), LOG_ERROR, format, args);
     va_end(args);
 }
 
@@ -23,9 +23,17 @@
 
 #include "message_delta.hpp"
 
+class ConsoleOutput;
+
 // Clears console
 void console_clear();
 
+// Takes a new console line to write into directly. Fills in id if given, so
+// console_line can tell if Halo has since reused the line for something else.
+ConsoleOutput* console_new_line(MemRef* id = NULL);
+// NULL if the line isn't the one id was given out for anymore.
+ConsoleOutput* console_line(MemRef id);
+
 // Print a formatted string to the Halo console.
 void vcprintf(const ARGBFloat& color, const char* format, va_list args);
 void cprintf (const ARGBFloat& color, const char* format, ...);
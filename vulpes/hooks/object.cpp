@@ -19,6 +19,7 @@
 #include <windows.h>
 
 #include <hooker/function_pointer_safe.hpp>
+#include <hooker/detour.hpp>
 #include <hooker/hooker.hpp>
 
 #include <vulpes/memory/behavior_definition.hpp>
@@ -26,6 +27,9 @@
 #include <vulpes/memory/types.hpp>
 #include <vulpes/memory/signatures.hpp>
 
+#include "object.hpp"
+#include "tick.hpp"
+
 
 // New behavior definitions, when initialized hooking into
 // one of these functions is as simple as re-assigning
@@ -117,84 +121,72 @@ extern "C" { // Demangle naming for ASM.
 
 static ObjectBehaviorDefinition* vanilla_def_pointers_backup[POSITIVE_OBJECT_TYPES];
 
-extern "C" {
-
-    uintptr_t after_object_hook__create;
-    extern object_create_wrapper();
-
-    uintptr_t after_weapon_hook__pull_trigger;
-    extern weapon_pull_trigger_wrapper();
-
-    uintptr_t after_biped_hook__jump;
-    extern biped_jump_wrapper();
-
+DEFINE_EVENT_HOOK_LIST(EVENT_OBJECT_CREATE, object_create_events);
+DEFINE_EVENT_HOOK_LIST(EVENT_OBJECT_CREATE_BATCH, object_create_batch_events);
+DEFINE_EVENT_HOOK_LIST(EVENT_BIPED_JUMP, biped_jump_events);
+DEFINE_EVENT_HOOK_LIST(EVENT_BIPED_JUMP_BATCH, biped_jump_batch_events);
+DEFINE_EVENT_HOOK_LIST(EVENT_WEAPON_PULL_TRIGGER, weapon_pull_trigger_events);
+DEFINE_EVENT_HOOK_LIST(EVENT_WEAPON_PULL_TRIGGER_BATCH, weapon_pull_trigger_batch_events);
+
+// Records for the batch hooks, handed out after every tick.
+// More than this in one tick just means an extra batch.
+const size_t OBJECT_EVENT_QUEUE_SIZE = 256;
+
+static EventQueue<ObjectEvent, OBJECT_EVENT_QUEUE_SIZE> object_create_queue;
+static EventQueue<ObjectEvent, OBJECT_EVENT_QUEUE_SIZE> biped_jump_queue;
+static EventQueue<ObjectEvent, OBJECT_EVENT_QUEUE_SIZE> weapon_pull_trigger_queue;
+
+template<class T, class B>
+static inline void object_event(uint32_t object, int32_t argument,
+                                EventList<T> &immediate, EventList<B> &batch,
+                                EventQueue<ObjectEvent, OBJECT_EVENT_QUEUE_SIZE> &queue) {
+    ObjectEvent event = {object, argument};
+    if (!immediate.empty()) call_in_order(immediate, &event);
+    // Nobody to hand them to, so don't even keep them.
+    if (!batch.empty()) queue.push(event, batch);
 }
 
-struct ObjectCreateArgs {
-    int unknown;
-    int unknown2;
-};
-
-extern "C" bool before_object_create(ObjectCreateArgs* args) {
-
-    // Stub: Hook current unused.
-
-    return true;
+static void flush_object_events() {
+    object_create_queue.flush(object_create_batch_events);
+    biped_jump_queue.flush(biped_jump_batch_events);
+    weapon_pull_trigger_queue.flush(weapon_pull_trigger_batch_events);
 }
 
-extern "C" void after_object_create(uint32_t* obj) {
-
-    // Stub: Hook current unused.
+// Gets a pointer to the handle of the new object.
 
+static void after_object_create(uint32_t* obj) {
+    object_event(*obj, 0,
+        object_create_events, object_create_batch_events, object_create_queue);
 }
 
-static Patch(
-    object_create_hook_patch, NULL, 6,
-    JMP_PATCH, &object_create_wrapper
-);
+static DetourHook(object_create_hook,
+    nullptr, &after_object_create, 2);
 
 // Only called when a biped actually jumps
 
-extern "C" bool before_biped_jump(uint32_t* obj) {
-
-    // Stub: Hook currently unused.
-
+static bool before_biped_jump(uint32_t* obj) {
+    object_event(*obj, 0,
+        biped_jump_events, biped_jump_batch_events, biped_jump_queue);
     return true;
 }
 
-extern "C" void after_biped_jump(uint32_t* obj) {
-
-    // Stub: Hook currently unused.
-
-}
-
-static Patch(
-    biped_jump_hook_patch, NULL, 6,
-    JMP_PATCH, &biped_jump_wrapper
-);
+static DetourHook(biped_jump_hook,
+    &before_biped_jump, nullptr, 1);
 
 struct WeaponPullTriggerArgs {
     uint32_t obj;
     int trigger_id;
 };
 
-extern "C" bool before_weapon_pull_trigger(WeaponPullTriggerArgs* args) {
-
-    // Stub: Hook current unused.
-
+static bool before_weapon_pull_trigger(WeaponPullTriggerArgs* args) {
+    object_event(args->obj, args->trigger_id,
+        weapon_pull_trigger_events, weapon_pull_trigger_batch_events,
+        weapon_pull_trigger_queue);
     return true;
 }
 
-extern "C" void after_weapon_pull_trigger() {
-
-    // Stub: Hook current unused.
-
-}
-
-static Patch(
-    weapon_pull_trigger_hook_patch, NULL, 6,
-    JMP_PATCH, &weapon_pull_trigger_wrapper
-);
+static DetourHook(weapon_pull_trigger_hook,
+    &before_weapon_pull_trigger, nullptr, 2);
 
 
 void init_object_hooks() {
@@ -405,27 +397,24 @@ void init_object_hooks() {
 
     // Objects:
 
-    object_create_hook_patch.build(sig_hook_object_create());
-    object_create_hook_patch.apply();
-    after_object_hook__create =
-        object_create_hook_patch.return_address();
+    object_create_hook.build(sig_hook_object_create());
+    object_create_hook.apply();
 
 
     // Bipeds:
 
-    biped_jump_hook_patch.build(sig_hook_biped_jump());
-    biped_jump_hook_patch.apply();
-    after_biped_hook__jump =
-        biped_jump_hook_patch.return_address();
+    biped_jump_hook.build(sig_hook_biped_jump());
+    biped_jump_hook.apply();
 
 
     // Weapons:
 
-    weapon_pull_trigger_hook_patch.build(sig_hook_weapon_pull_trigger());
-    weapon_pull_trigger_hook_patch.apply();
-    after_weapon_hook__pull_trigger =
-        weapon_pull_trigger_hook_patch.return_address();
+    weapon_pull_trigger_hook.build(sig_hook_weapon_pull_trigger());
+    weapon_pull_trigger_hook.apply();
+
+    // The batches go out right after each tick.
 
+    ADD_CALLBACK_P(EVENT_TICK, flush_object_events, EVENT_PRIORITY_BEFORE);
 
 }
 
@@ -444,8 +433,11 @@ void revert_object_hooks() {
 
     //////// Other hooks:
 
-    // Weapons:
+    object_create_hook.revert();
+    biped_jump_hook.revert();
+    weapon_pull_trigger_hook.revert();
 
-    weapon_pull_trigger_hook_patch.revert();
+    DEL_CALLBACK(EVENT_TICK, flush_object_events);
+    flush_object_events();
 
 }
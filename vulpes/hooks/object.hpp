@@ -17,5 +17,36 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
+#include <vulpes/event.hpp>
+
+/// Something that happened to an object.
+struct ObjectEvent {
+    /// Handle of the object.
+    uint32_t object;
+    /// For weapon triggers the trigger index, otherwise 0.
+    int32_t argument;
+};
+
+// These events can happen hundreds of times per tick during a big fight.
+// Every one of them can be handled in two ways:
+//
+// The plain hooks are called the moment it happens, with a single event.
+//
+// The _BATCH hooks are called once per tick, right after it, with all the
+// events of that tick in the order they happened. Use these unless you
+// need to act before the game continues.
+
+DEFINE_EVENT_HOOK(EVENT_OBJECT_CREATE, void, const ObjectEvent* event);
+DEFINE_EVENT_HOOK(EVENT_OBJECT_CREATE_BATCH, void, const ObjectEvent* events, size_t count);
+
+DEFINE_EVENT_HOOK(EVENT_BIPED_JUMP, void, const ObjectEvent* event);
+DEFINE_EVENT_HOOK(EVENT_BIPED_JUMP_BATCH, void, const ObjectEvent* events, size_t count);
+
+DEFINE_EVENT_HOOK(EVENT_WEAPON_PULL_TRIGGER, void, const ObjectEvent* event);
+DEFINE_EVENT_HOOK(EVENT_WEAPON_PULL_TRIGGER_BATCH, void, const ObjectEvent* events, size_t count);
+
 void init_object_hooks();
 void revert_object_hooks();
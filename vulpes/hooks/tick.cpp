@@ -15,8 +15,13 @@
  * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
  */
 
-#include <hooker/hooker.hpp>
+#include <hooker/detour.hpp>
+#include <vulpes/command/queue.hpp>
+#include <vulpes/debug/clock.hpp>
+#include <vulpes/debug/tick_profiler.hpp>
 #include <vulpes/memory/signatures.hpp>
+#include <vulpes/jobs.hpp>
+#include <vulpes/timers.hpp>
 
 #include "tick.hpp"
 
@@ -26,33 +31,46 @@ DEFINE_EVENT_HOOK_LIST(EVENT_PRE_TICK, pre_events);
 DEFINE_EVENT_HOOK_LIST(EVENT_TICK, events);
 
 
-extern "C" bool before_tick(uint32_t* last_tick_index) {
-    call_in_order(pre_events);
-    return true;
-}
+// When the pre tick events started and ended, for the tick profiler.
+static uint64_t pre_start;
+static uint64_t pre_end;
 
-extern "C" void after_tick() {
-    call_in_order(events);
+static bool before_tick(uint32_t* last_tick_index) {
+    if (tick_profiler_enabled()) {
+        pre_start = clock_now();
+        call_in_order(pre_events);
+        pre_end = clock_now();
+    } else {
+        pre_start = 0;
+        call_in_order(pre_events);
+    }
+    return true;
 }
 
-extern "C" {
-
-    uintptr_t game_tick_actual_jmp;
-    extern game_tick_wrapper();
-
+static void after_tick() {
+    // Only count ticks the profiler saw start.
+    if (pre_start && tick_profiler_enabled()) {
+        uint64_t post_start = clock_now();
+        call_in_order(events);
+        advance_timers();
+        deliver_finished_jobs(JOBS_DELIVERED_PER_TICK);
+        run_queued_commands();
+        tick_profiler_record(pre_start, pre_end, post_start, clock_now());
+    } else {
+        call_in_order(events);
+        advance_timers();
+        deliver_finished_jobs(JOBS_DELIVERED_PER_TICK);
+        run_queued_commands();
+    }
 }
 
-static Patch(
-    tick_hook_patch, NULL, 7,
-    JMP_PATCH, &game_tick_wrapper
-);
+static DetourHook(tick_hook, &before_tick, &after_tick, 1);
 
 void init_tick_hook() {
-    tick_hook_patch.build(sig_hook_tick());
-    tick_hook_patch.apply();
-    game_tick_actual_jmp = tick_hook_patch.return_address();
+    tick_hook.build(sig_hook_tick());
+    tick_hook.apply();
 }
 
 void revert_tick_hook() {
-    tick_hook_patch.revert();
+    tick_hook.revert();
 }
@@ -0,0 +1,164 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <deque>
+
+#include <util/threads.hpp>
+
+#include "jobs.hpp"
+
+struct Job {
+    JobFunction work;
+    JobFunction done;
+    void* data;
+    std::atomic<Job*> next;
+};
+
+// Jobs waiting for a worker. Only the game thread adds to this in practice,
+// so a plain lock is fine here. The lock and semaphore are never freed, a
+// worker that is told to stop may still be waiting on them.
+static Lock* waiting_lock = NULL;
+static std::deque<Job*> waiting_jobs;
+static Semaphore* jobs_waiting = NULL;
+
+static std::atomic<bool> stopping(false);
+static size_t worker_count = 0;
+static bool workers_started = false;
+
+// Finished jobs, added to by every worker and only taken from by the game
+// thread, so it can be lock free. It's a linked list where workers swap
+// themselves in at the head and the game thread walks from the tail.
+// There is always at least the stub in it, so head and tail are never NULL.
+static Job finished_stub;
+static std::atomic<Job*> finished_head(&finished_stub);
+static Job* finished_tail = &finished_stub;
+
+static void push_finished(Job* job) {
+    job->next.store(NULL, std::memory_order_relaxed);
+    Job* previous = finished_head.exchange(job, std::memory_order_acq_rel);
+    // Between the exchange and this store the list is briefly cut in two,
+    // pop_finished sees that as empty and tries again next time.
+    previous->next.store(job, std::memory_order_release);
+}
+
+static Job* pop_finished() {
+    Job* tail = finished_tail;
+    Job* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &finished_stub) {
+        if (!next) return NULL;
+        finished_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        finished_tail = next;
+        return tail;
+    }
+    // tail is the last one, unless a worker is halfway adding one.
+    if (tail != finished_head.load(std::memory_order_acquire)) return NULL;
+    // Put the stub back behind it, so it can be taken out.
+    push_finished(&finished_stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        finished_tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+static void worker_main(void*) {
+    while (true) {
+        jobs_waiting->wait();
+        if (stopping) break;
+
+        waiting_lock->lock();
+        Job* job = NULL;
+        if (!waiting_jobs.empty()) {
+            job = waiting_jobs.front();
+            waiting_jobs.pop_front();
+        }
+        waiting_lock->unlock();
+
+        if (job) {
+            job->work(job->data);
+            push_finished(job);
+        }
+    }
+}
+
+static void start_workers() {
+    workers_started = true;
+
+    // Leave a core for the game, but a couple of workers is plenty for IO.
+    size_t processors = processor_count();
+    size_t wanted = processors > 1 ? processors - 1 : 1;
+    if (wanted > 4) wanted = 4;
+
+    waiting_lock = new Lock;
+    jobs_waiting = new Semaphore;
+
+    for (size_t i = 0; jobs_waiting->valid() && i < wanted; i++) {
+        if (!start_thread(worker_main, NULL)) break;
+        worker_count++;
+    }
+    if (worker_count == 0) {
+        printf("Couldn't start worker threads, jobs will run on the game thread.\n");
+    }
+}
+
+void run_job(JobFunction work, JobFunction done, void* data) {
+    if (!workers_started) start_workers();
+
+    auto job = new Job;
+    job->work = work;
+    job->done = done;
+    job->data = data;
+
+    if (worker_count == 0 || stopping) {
+        work(data);
+        push_finished(job);
+        return;
+    }
+
+    waiting_lock->lock();
+    waiting_jobs.push_back(job);
+    waiting_lock->unlock();
+    jobs_waiting->release();
+}
+
+size_t deliver_finished_jobs(size_t max) {
+    size_t delivered = 0;
+    while (delivered < max) {
+        Job* job = pop_finished();
+        if (!job) break;
+        if (job->done) job->done(job->data);
+        delete job;
+        delivered++;
+    }
+    return delivered;
+}
+
+void stop_workers() {
+    if (worker_count == 0) return;
+    // We can be called from DllMain, where waiting for threads to end would
+    // never return. So only tell them to stop.
+    stopping = true;
+    jobs_waiting->release(worker_count);
+    worker_count = 0;
+}
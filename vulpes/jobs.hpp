@@ -0,0 +1,44 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+
+// Runs slow work, like file IO, on a few background threads.
+//
+// work(data) runs on a worker thread, and must not touch the game or Vulpes
+// state that the game thread uses. Once it is done, done(data) is called on
+// the game thread right after a tick, where it is safe to use the result.
+// done can be NULL.
+//
+// The workers start when the first job comes in. If they can't be started
+// the work is done right away, done still waits for the next tick.
+typedef void (*JobFunction)(void* data);
+
+void run_job(JobFunction work, JobFunction done, void* data);
+
+// How many finished jobs get their done called after a tick at most. The
+// rest wait for the ticks after, so a pile of results can't cause a hitch.
+const size_t JOBS_DELIVERED_PER_TICK = 16;
+
+// Called by the tick hook. Returns how many jobs were delivered.
+size_t deliver_finished_jobs(size_t max);
+
+// Lets the workers quit once they are done with their current job.
+// Jobs that haven't started yet are dropped.
+void stop_workers();
@@ -0,0 +1,321 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+
+#include <util/threads.hpp>
+
+#include "log.hpp"
+
+// The buffer works like a ring of slots that are taken in order. A slot's
+// sequence says what it holds, for the nth time around the ring it's 2n
+// while it is free and 2n+1 once a line is in it. That way it starts out
+// right with all zeroes.
+//
+// Deferred lines have their format, with the arguments in data. Other lines
+// have no format and just the text.
+struct LogRecord {
+    std::atomic<uint64_t> sequence;
+    LogSeverity severity;
+    time_t time;
+    const char* format;
+    uint16_t size;
+    char data[LOG_LINE_CHARS];
+};
+
+static_assert(LOG_ARGS_SIZE <= LOG_LINE_CHARS, "Deferred arguments need to fit in a log record.");
+
+static LogRecord records[LOG_LINES_BUFFERED];
+static std::atomic<uint64_t> log_head(0);
+// Only touched by whoever holds writing.
+static uint64_t log_tail = 0;
+static std::atomic_flag writing = ATOMIC_FLAG_INIT;
+
+static std::atomic<size_t> dropped(0);
+static std::atomic<bool> filters[LOG_SEVERITIES] = {
+    {true}, {true}, {true}, {true}
+};
+
+// How long the writer waits between looking for new lines.
+static const unsigned LOG_WRITE_INTERVAL_MS = 100;
+
+static std::string log_directory;
+static FILE* log_file = NULL;
+static size_t log_file_size = 0;
+static bool file_binary = false;
+// Format strings that already have an id in the binary log file.
+static std::unordered_map<const char*, uint32_t> format_ids;
+static std::atomic<bool> binary(false);
+static std::atomic<bool> stopping(false);
+static bool started = false;
+
+static uint64_t free_sequence(uint64_t position) {
+    return 2 * (position / LOG_LINES_BUFFERED);
+}
+
+// Claims the next free slot, or returns NULL when the buffer is full.
+static LogRecord* take_record(uint64_t* taken) {
+    uint64_t position = log_head.load(std::memory_order_relaxed);
+    while (true) {
+        LogRecord* record = &records[position % LOG_LINES_BUFFERED];
+        uint64_t sequence = record->sequence.load(std::memory_order_acquire);
+        if (sequence == free_sequence(position)) {
+            if (log_head.compare_exchange_weak(position, position + 1,
+                                               std::memory_order_relaxed)) {
+                *taken = position;
+                return record;
+            }
+        } else if (sequence < free_sequence(position)) {
+            // Still holds a line from last time around, we're full.
+            dropped++;
+            return NULL;
+        } else {
+            position = log_head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+static void publish_record(LogRecord* record, uint64_t position) {
+    record->sequence.store(free_sequence(position) + 1, std::memory_order_release);
+}
+
+void log_line(LogSeverity severity, const char* text) {
+    if (!filters[severity].load(std::memory_order_relaxed)) return;
+
+    uint64_t position;
+    LogRecord* record = take_record(&position);
+    if (!record) return;
+
+    record->severity = severity;
+    record->time = time(NULL);
+    record->format = NULL;
+    strncpy(record->data, text, LOG_LINE_CHARS - 1);
+    record->data[LOG_LINE_CHARS - 1] = '\0';
+    publish_record(record, position);
+}
+
+void log_args(LogSeverity severity, const char* format, const LogArgs& args) {
+    if (!filters[severity].load(std::memory_order_relaxed)) return;
+
+    uint64_t position;
+    LogRecord* record = take_record(&position);
+    if (!record) return;
+
+    record->severity = severity;
+    record->time = time(NULL);
+    record->format = format;
+    record->size = args.size;
+    memcpy(record->data, args.data, args.size);
+    publish_record(record, position);
+}
+
+void vlog_printf(LogSeverity severity, const char* format, va_list args) {
+    if (!filters[severity].load(std::memory_order_relaxed)) return;
+    char text[LOG_LINE_CHARS];
+    vsnprintf(text, LOG_LINE_CHARS, format, args);
+    log_line(severity, text);
+}
+
+void log_printf(LogSeverity severity, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vlog_printf(severity, format, args);
+    va_end(args);
+}
+
+void set_log_filter(LogSeverity severity, bool on) {
+    filters[severity] = on;
+}
+
+bool log_filter(LogSeverity severity) {
+    return filters[severity];
+}
+
+void set_log_binary(bool on) {
+    binary = on;
+}
+
+bool log_binary() {
+    return binary;
+}
+
+size_t log_lines_dropped() {
+    return dropped;
+}
+
+static std::string log_file_path(size_t number) {
+    const char* extension = file_binary ? ".vlog" : ".log";
+    if (number == 0) {
+        return log_directory + "/vulpes" + extension;
+    }
+    return log_directory + "/vulpes." + std::to_string(number) + extension;
+}
+
+static void write_bytes(const void* data, size_t size) {
+    log_file_size += fwrite(data, 1, size, log_file);
+}
+
+template<typename T>
+static void write_value(T value) {
+    write_bytes(&value, sizeof(T));
+}
+
+static void open_log_file() {
+    file_binary = binary;
+    log_file = fopen(log_file_path(0).data(), "ab");
+    log_file_size = 0;
+    if (log_file) {
+        fseek(log_file, 0, SEEK_END);
+        log_file_size = ftell(log_file);
+        if (file_binary) {
+            format_ids.clear();
+            write_value(LOG_ENTRY_START);
+            write_bytes(LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC));
+            write_value(LOG_BINARY_VERSION);
+        }
+    }
+}
+
+static void rotate_log_files() {
+    fclose(log_file);
+    remove(log_file_path(LOG_FILES_KEPT).data());
+    for (size_t i = LOG_FILES_KEPT; i > 0; i--) {
+        rename(log_file_path(i - 1).data(), log_file_path(i).data());
+    }
+    open_log_file();
+}
+
+static void write_binary_record(const LogRecord* record) {
+    if (!record->format) {
+        uint16_t length = strlen(record->data);
+        write_value(LOG_ENTRY_TEXT);
+        write_value(static_cast<int64_t>(record->time));
+        write_value(static_cast<uint8_t>(record->severity));
+        write_value(length);
+        write_bytes(record->data, length);
+        return;
+    }
+
+    // The format string only gets written the first time it's used.
+    auto id = format_ids.find(record->format);
+    if (id == format_ids.end()) {
+        id = format_ids.emplace(record->format, format_ids.size()).first;
+        uint16_t length = strlen(record->format);
+        write_value(LOG_ENTRY_FORMAT);
+        write_value(id->second);
+        write_value(length);
+        write_bytes(record->format, length);
+    }
+    write_value(LOG_ENTRY_LINE);
+    write_value(static_cast<int64_t>(record->time));
+    write_value(static_cast<uint8_t>(record->severity));
+    write_value(id->second);
+    write_value(record->size);
+    write_bytes(record->data, record->size);
+}
+
+static void write_text_record(const LogRecord* record) {
+    char formatted[LOG_LINE_CHARS * 4];
+    const char* text = record->data;
+    if (record->format) {
+        format_log_args(formatted, sizeof(formatted), record->format,
+                        reinterpret_cast<const uint8_t*>(record->data), record->size);
+        text = formatted;
+    }
+    char line[LOG_LINE_CHARS * 4 + 32];
+    size_t length = format_log_line(line, sizeof(line) - 1, record->time,
+                                    record->severity, text);
+    line[length++] = '\n';
+    write_bytes(line, length);
+}
+
+// Writes every line that is ready. Only one thread can do this at a time.
+static void write_log_lines() {
+    if (writing.test_and_set(std::memory_order_acquire)) return;
+
+    if (log_file && file_binary != binary) {
+        fclose(log_file);
+        open_log_file();
+    }
+
+    bool wrote = false;
+    while (true) {
+        LogRecord* record = &records[log_tail % LOG_LINES_BUFFERED];
+        uint64_t sequence = record->sequence.load(std::memory_order_acquire);
+        if (sequence != free_sequence(log_tail) + 1) break;
+
+        if (log_file) {
+            if (file_binary) {
+                write_binary_record(record);
+            } else {
+                write_text_record(record);
+            }
+            wrote = true;
+        }
+        record->sequence.store(free_sequence(log_tail + LOG_LINES_BUFFERED),
+                               std::memory_order_release);
+        log_tail++;
+
+        if (log_file && log_file_size >= LOG_FILE_SIZE) {
+            rotate_log_files();
+        }
+    }
+    if (wrote && log_file) fflush(log_file);
+
+    writing.clear(std::memory_order_release);
+}
+
+static void log_writer_main(void*) {
+    while (!stopping) {
+        write_log_lines();
+        sleep_milliseconds(LOG_WRITE_INTERVAL_MS);
+    }
+}
+
+void init_log(const char* directory) {
+    if (started) return;
+    started = true;
+
+    log_directory = directory;
+    open_log_file();
+    if (!log_file) {
+        printf("Couldn't open %s, Vulpes won't log to a file.\n",
+               log_file_path(0).data());
+        return;
+    }
+    if (!start_thread(log_writer_main, NULL)) {
+        printf("Couldn't start the log writer.\n");
+    }
+}
+
+void flush_log() {
+    write_log_lines();
+}
+
+void stop_log() {
+    if (!started) return;
+    // We can be called from DllMain, where waiting for the writer to end
+    // would never return. So write what is left ourselves if we can.
+    stopping = true;
+    write_log_lines();
+}
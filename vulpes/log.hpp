@@ -0,0 +1,83 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+
+#include "log_format.hpp"
+
+// A log file, mostly for dedicated servers.
+//
+// Logging a line only copies it into a ring buffer. A background thread
+// writes the buffer out to the log file every so often, so logging never
+// waits on the disk. If lines come in faster than they can be written the
+// newest ones are dropped and counted, the buffer never grows.
+//
+// Once the log file is LOG_FILE_SIZE it is moved to vulpes.1.log, the old
+// vulpes.1.log to vulpes.2.log, and so on. LOG_FILES_KEPT old files are kept.
+//
+// Lines that are logged often can use log_deferred, which doesn't format
+// anything on the calling thread. The writer formats them, or when the log is
+// binary they go to vulpes.vlog as they are and vulpes_log_decode turns them
+// into text later.
+
+const size_t LOG_LINES_BUFFERED = 512;
+const size_t LOG_LINE_CHARS = 256;
+const size_t LOG_FILE_SIZE = 1024 * 1024;
+const size_t LOG_FILES_KEPT = 4;
+
+// Safe to call from any thread.
+void log_line(LogSeverity severity, const char* text);
+void vlog_printf(LogSeverity severity, const char* format, va_list args);
+void log_printf(LogSeverity severity, const char* format, ...);
+
+// Whether lines of this severity get logged. They all do by default.
+void set_log_filter(LogSeverity severity, bool on);
+bool log_filter(LogSeverity severity);
+
+// Keeps format and the arguments as they are, to be formatted later.
+// format needs to stay around, so it should be a string literal.
+// Arguments can be numbers, pointers and strings.
+void log_args(LogSeverity severity, const char* format, const LogArgs& args);
+
+template<typename... Args>
+void log_deferred(LogSeverity severity, const char* format, Args... args) {
+    if (!log_filter(severity)) return;
+    LogArgs buffer;
+    (buffer.add(args), ...);
+    log_args(severity, format, buffer);
+}
+
+// Whether the log is written to vulpes.vlog as binary instead. Takes effect
+// the next time the writer looks for lines.
+void set_log_binary(bool on);
+bool log_binary();
+
+// How many lines didn't fit in the buffer.
+size_t log_lines_dropped();
+
+// Starts writing to vulpes.log in directory. Lines logged before this wait
+// in the buffer.
+void init_log(const char* directory);
+
+// Writes out the lines that are ready now, unless another thread already is.
+void flush_log();
+
+// Writes out what is left, if the writer isn't busy, and stops the writer.
+void stop_log();
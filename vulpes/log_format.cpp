@@ -0,0 +1,214 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <cstdio>
+
+#include "log_format.hpp"
+
+const char* LOG_SEVERITY_NAMES[LOG_SEVERITIES] = {
+    "message", "info", "warning", "error"
+};
+
+struct LogArg {
+    LogArgType type;
+    int64_t integer;
+    double real;
+    const char* string;
+    size_t length;
+};
+
+// Takes the next argument out of args. False once there are none left.
+static bool next_log_arg(const uint8_t** args, const uint8_t* end, LogArg* arg) {
+    const uint8_t* at = *args;
+    if (at >= end) return false;
+    arg->type = static_cast<LogArgType>(*at++);
+    arg->integer = 0;
+    arg->real = 0.0;
+    arg->string = NULL;
+    arg->length = 0;
+    switch (arg->type) {
+    case LOG_ARG_INT32: {
+        int32_t value;
+        if (end - at < static_cast<ptrdiff_t>(sizeof(value))) return false;
+        memcpy(&value, at, sizeof(value));
+        at += sizeof(value);
+        arg->integer = value;
+        arg->real = value;
+        break;
+    }
+    case LOG_ARG_INT64:
+    case LOG_ARG_POINTER: {
+        int64_t value;
+        if (end - at < static_cast<ptrdiff_t>(sizeof(value))) return false;
+        memcpy(&value, at, sizeof(value));
+        at += sizeof(value);
+        arg->integer = value;
+        arg->real = value;
+        break;
+    }
+    case LOG_ARG_DOUBLE:
+        if (end - at < static_cast<ptrdiff_t>(sizeof(double))) return false;
+        memcpy(&arg->real, at, sizeof(double));
+        at += sizeof(double);
+        arg->integer = static_cast<int64_t>(arg->real);
+        break;
+    case LOG_ARG_STRING:
+        if (at >= end) return false;
+        arg->length = *at++;
+        if (end - at < static_cast<ptrdiff_t>(arg->length)) return false;
+        arg->string = reinterpret_cast<const char*>(at);
+        at += arg->length;
+        break;
+    default:
+        return false;
+    }
+    *args = at;
+    return true;
+}
+
+size_t format_log_args(char* out, size_t size, const char* format,
+                       const uint8_t* args, size_t args_size) {
+    if (size == 0) return 0;
+    const uint8_t* end = args + args_size;
+    size_t used = 0;
+
+    // snprintf returns how long it would have liked to be.
+    auto advance = [&](int written) {
+        if (written > 0) used += written;
+        if (used > size - 1) used = size - 1;
+    };
+
+    const char* at = format;
+    while (*at && used < size - 1) {
+        if (*at != '%') {
+            out[used++] = *at++;
+            continue;
+        }
+        if (at[1] == '%') {
+            out[used++] = '%';
+            at += 2;
+            continue;
+        }
+
+        // Rebuild the conversion without its length, so we can put in the
+        // one that matches what we stored. Any * get their number filled in.
+        char spec[32] = "%";
+        size_t spec_length = 1;
+        const char* c = at + 1;
+        auto spec_add = [&](char ch) {
+            if (spec_length < sizeof(spec) - 4) spec[spec_length++] = ch;
+        };
+        while (*c && strchr("-+ #0", *c)) spec_add(*c++);
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*c != '.') break;
+                spec_add(*c++);
+            }
+            if (*c == '*') {
+                LogArg arg;
+                int number = next_log_arg(&args, end, &arg) ? arg.integer : 0;
+                char digits[16];
+                snprintf(digits, sizeof(digits), "%d", number);
+                for (const char* d = digits; *d; d++) spec_add(*d);
+                c++;
+            } else {
+                while (*c >= '0' && *c <= '9') spec_add(*c++);
+            }
+        }
+        while (*c && strchr("hlLqjzt", *c)) c++;
+        if (c[0] == 'I' && ((c[1] == '6' && c[2] == '4') || (c[1] == '3' && c[2] == '2'))) {
+            c += 3;
+        } else if (*c == 'I') {
+            c++;
+        }
+
+        char conversion = *c;
+        if (!conversion) break;
+        at = c + 1;
+
+        LogArg arg;
+        bool have_arg = next_log_arg(&args, end, &arg);
+        if (conversion == 'n') continue;
+        bool is_string = have_arg && arg.type == LOG_ARG_STRING;
+        size_t left = size - used;
+        char* to = out + used;
+
+        if (!have_arg || (is_string != (conversion == 's'))) {
+            advance(snprintf(to, left, "(?)"));
+            continue;
+        }
+
+        switch (conversion) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            if (arg.type == LOG_ARG_INT32) {
+                spec[spec_length] = conversion;
+                spec[spec_length + 1] = '\0';
+                advance(snprintf(to, left, spec, static_cast<int32_t>(arg.integer)));
+            } else {
+                spec[spec_length] = 'l';
+                spec[spec_length + 1] = 'l';
+                spec[spec_length + 2] = conversion;
+                spec[spec_length + 3] = '\0';
+                advance(snprintf(to, left, spec, static_cast<long long>(arg.integer)));
+            }
+            break;
+        case 'c':
+            spec[spec_length] = 'c';
+            spec[spec_length + 1] = '\0';
+            advance(snprintf(to, left, spec, static_cast<int>(arg.integer)));
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec[spec_length] = conversion;
+            spec[spec_length + 1] = '\0';
+            advance(snprintf(to, left, spec, arg.real));
+            break;
+        case 's': {
+            char text[256];
+            memcpy(text, arg.string, arg.length);
+            text[arg.length] = '\0';
+            spec[spec_length] = 's';
+            spec[spec_length + 1] = '\0';
+            advance(snprintf(to, left, spec, text));
+            break;
+        }
+        case 'p':
+            spec[spec_length] = 'p';
+            spec[spec_length + 1] = '\0';
+            advance(snprintf(to, left, spec,
+                             reinterpret_cast<void*>(static_cast<uintptr_t>(arg.integer))));
+            break;
+        default:
+            advance(snprintf(to, left, "(?)"));
+            break;
+        }
+    }
+    out[used] = '\0';
+    return used;
+}
+
+size_t format_log_line(char* out, size_t size, time_t time,
+                       LogSeverity severity, const char* text) {
+    char time_text[32] = "";
+    struct tm* local = localtime(&time);
+    if (local) {
+        strftime(time_text, sizeof(time_text), "%Y-%m-%d %H:%M:%S", local);
+    }
+    const char* name = severity < LOG_SEVERITIES ? LOG_SEVERITY_NAMES[severity] : "?";
+    int written = snprintf(out, size, "%s %-7s %s", time_text, name, text);
+    if (written < 0) return 0;
+    return static_cast<size_t>(written) < size ? written : size - 1;
+}
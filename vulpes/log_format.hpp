@@ -0,0 +1,131 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <type_traits>
+
+// What goes into the log, shared between Vulpes and the log decoder.
+//
+// A deferred line is a format string and its arguments as raw values. Every
+// argument is a type byte followed by the value. Strings get copied in as a
+// length byte and the characters, as they might not be around anymore by the
+// time the line gets formatted.
+
+enum LogSeverity {
+    LOG_MESSAGE,
+    LOG_INFO,
+    LOG_WARNING,
+    LOG_ERROR,
+    LOG_SEVERITIES
+};
+
+extern const char* LOG_SEVERITY_NAMES[LOG_SEVERITIES];
+
+enum LogArgType : uint8_t {
+    LOG_ARG_INT32 = 1,
+    LOG_ARG_INT64,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STRING,
+    LOG_ARG_POINTER
+};
+
+const size_t LOG_ARGS_SIZE = 240;
+
+class LogArgs {
+public:
+    uint8_t data[LOG_ARGS_SIZE];
+    size_t size = 0;
+
+    void add(const char* string) {
+        if (!string) string = "(null)";
+        size_t length = strlen(string);
+        if (size + 2 > LOG_ARGS_SIZE) return;
+        if (length > LOG_ARGS_SIZE - size - 2) {
+            length = LOG_ARGS_SIZE - size - 2;
+        }
+        if (length > 255) length = 255;
+        data[size++] = LOG_ARG_STRING;
+        data[size++] = length;
+        memcpy(&data[size], string, length);
+        size += length;
+    }
+
+    void add(char* string) {
+        add(const_cast<const char*>(string));
+    }
+
+    template<typename T>
+    void add(T value) {
+        if constexpr (std::is_floating_point<T>::value) {
+            add_raw(LOG_ARG_DOUBLE, static_cast<double>(value));
+        } else if constexpr (std::is_pointer<T>::value) {
+            add_raw(LOG_ARG_POINTER, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+        } else if constexpr (sizeof(T) <= sizeof(int32_t)) {
+            static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                          "Deferred log arguments need to be numbers, pointers or strings.");
+            add_raw(LOG_ARG_INT32, static_cast<int32_t>(value));
+        } else {
+            static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                          "Deferred log arguments need to be numbers, pointers or strings.");
+            add_raw(LOG_ARG_INT64, static_cast<int64_t>(value));
+        }
+    }
+
+private:
+    template<typename T>
+    void add_raw(LogArgType type, T value) {
+        if (size + 1 + sizeof(T) > LOG_ARGS_SIZE) return;
+        data[size++] = type;
+        memcpy(&data[size], &value, sizeof(T));
+        size += sizeof(T);
+    }
+};
+
+// Formats like snprintf would, but takes the arguments from a LogArgs buffer.
+// Arguments that don't fit their conversion come out as (?).
+// Returns the length of the text in out.
+size_t format_log_args(char* out, size_t size, const char* format,
+                       const uint8_t* args, size_t args_size);
+
+// "2020-01-31 12:00:00 info    text", without a newline.
+size_t format_log_line(char* out, size_t size, time_t time,
+                       LogSeverity severity, const char* text);
+
+// Binary logs are made of entries that each start with a LogEntryType byte.
+// Everything is little endian, as written by x86.
+//
+// LOG_ENTRY_START    "VLOG", uint8_t version. Written whenever a file is
+//                    opened, format ids from before it don't count anymore.
+// LOG_ENTRY_FORMAT   uint32_t id, uint16_t length, the format string.
+// LOG_ENTRY_LINE     int64_t time, uint8_t severity, uint32_t format id,
+//                    uint16_t size, the LogArgs data.
+// LOG_ENTRY_TEXT     int64_t time, uint8_t severity, uint16_t length, text.
+
+enum LogEntryType : uint8_t {
+    LOG_ENTRY_START = 1,
+    LOG_ENTRY_FORMAT,
+    LOG_ENTRY_LINE,
+    LOG_ENTRY_TEXT
+};
+
+const char LOG_BINARY_MAGIC[4] = {'V', 'L', 'O', 'G'};
+const uint8_t LOG_BINARY_VERSION = 1;
@@ -30,6 +30,7 @@
 #include "lua_console.hpp"
 #include "lua_helpers.hpp"
 #include "lua_open.hpp"
+#include "lua_timer.hpp"
 
 static lua_State* map_state = NULL;
 
@@ -40,6 +41,7 @@ static const auto LUA_MAIN_FILE = std::string("main.lua");
 static void luaV_register_functions(lua_State *state, bool sandboxed) {
     luaV_openlibs(state, !sandboxed);
     luaV_register_console(state);
+    luaV_register_timer(state);
 }
 
 //TODO: Make this load scripts from maps.
@@ -68,6 +70,8 @@ static void luaV_load_scripts_for_map() {
                 cur_map_name + ":" + LUA_MAIN_FILE)
             || lua_pcall(state, 0, 0, 0)) {
                 luaV_print_error(state);
+                // main.lua may have started timers before it failed.
+                luaV_cancel_timers(state);
                 lua_close(state);
             } else {
                 // State setup was succesful, save a reference to it globally.
@@ -81,6 +85,7 @@ static void luaV_load_scripts_for_map() {
 static void luaV_unload_scripts_for_map() {
     if (map_state != NULL) {
         cprintf_info("Closing previous map-lua state.");
+        luaV_cancel_timers(map_state);
         lua_close(map_state);
         map_state = NULL;
     }
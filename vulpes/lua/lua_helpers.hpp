@@ -32,9 +32,9 @@ static inline void luaV_print_error(lua_State *state) {
     // Print whatever is at the top of the lua stack.
     // This should be an error when this function is called.
     auto text = lua_tostring(state, -1);
+    // This also puts it in the log file.
     cprintf_error("%s", text);
     printf("%s", text);
-    // TODO: Make errors log to a file.
     lua_pop(state, 1);
 }
 
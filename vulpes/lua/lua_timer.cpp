@@ -0,0 +1,139 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <unordered_map>
+
+#include <lua.hpp>
+
+#include <util/nanoluadict.hpp>
+
+#include <vulpes/timers.hpp>
+
+#include "lua_helpers.hpp"
+#include "lua_timer.hpp"
+
+// Lua timers all share one C function, this is what it needs to know to
+// call the right Lua function.
+struct LuaTimer {
+    lua_State *state;
+    // Reference to the function in the registry.
+    int function;
+};
+
+static std::unordered_map<TimerHandle, LuaTimer> lua_timers;
+
+static void luaV_forget_timer(TimerHandle timer) {
+    auto found = lua_timers.find(timer);
+    if (found == lua_timers.end()) return;
+    luaL_unref(found->second.state, LUA_REGISTRYINDEX, found->second.function);
+    lua_timers.erase(found);
+}
+
+static void luaV_run_timer(TimerHandle timer, void *context) {
+    auto found = lua_timers.find(timer);
+    if (found == lua_timers.end()) return;
+    auto state = found->second.state;
+
+    lua_rawgeti(state, LUA_REGISTRYINDEX, found->second.function);
+    lua_pushnumber(state, timer);
+    if (lua_pcall(state, 1, 0, 0)) {
+        luaV_print_error(state);
+        // It would only error again next time.
+        timer_cancel(timer);
+    }
+    // Timers that only run once are done, and the function may have
+    // cancelled its own.
+    if (!timer_active(timer)) {
+        luaV_forget_timer(timer);
+    }
+}
+
+static int luaV_start_timer(lua_State *state, bool repeat) {
+    auto ticks = luaL_checkinteger(state, 1);
+    luaL_checktype(state, 2, LUA_TFUNCTION);
+    if (ticks < 0) {
+        return luaL_error(state, "Timers can't go back in time.");
+    }
+
+    lua_pushvalue(state, 2);
+    int function = luaL_ref(state, LUA_REGISTRYINDEX);
+
+    TimerHandle timer;
+    if (repeat) {
+        timer = timer_every(ticks, &luaV_run_timer);
+    } else {
+        timer = timer_after(ticks, &luaV_run_timer);
+    }
+    lua_timers[timer] = {state, function};
+
+    lua_pushnumber(state, timer);
+    return 1;
+}
+
+static int luaV_timer_after(lua_State *state) {
+    return luaV_start_timer(state, false);
+}
+
+static int luaV_timer_every(lua_State *state) {
+    return luaV_start_timer(state, true);
+}
+
+static int luaV_timer_cancel(lua_State *state) {
+    auto timer = static_cast<TimerHandle>(luaL_checknumber(state, 1));
+    auto found = lua_timers.find(timer);
+    // Scripts can only cancel their own timers.
+    bool cancelled = found != lua_timers.end()
+                  && found->second.state == state
+                  && timer_cancel(timer);
+    if (cancelled) {
+        luaV_forget_timer(timer);
+    }
+    lua_pushboolean(state, cancelled);
+    return 1;
+}
+
+static int luaV_timer_active(lua_State *state) {
+    auto timer = static_cast<TimerHandle>(luaL_checknumber(state, 1));
+    auto found = lua_timers.find(timer);
+    lua_pushboolean(state, found != lua_timers.end()
+                        && found->second.state == state
+                        && timer_active(timer));
+    return 1;
+}
+
+void luaV_register_timer(lua_State *state) {
+    luaDict(state,
+        "timer",
+        4,
+        kvPairWithCFunction("after", luaV_timer_after),
+        kvPairWithCFunction("every", luaV_timer_every),
+        kvPairWithCFunction("cancel", luaV_timer_cancel),
+        kvPairWithCFunction("active", luaV_timer_active)
+    );
+}
+
+void luaV_cancel_timers(lua_State *state) {
+    for (auto it = lua_timers.begin(); it != lua_timers.end();) {
+        if (it->second.state == state) {
+            timer_cancel(it->first);
+            luaL_unref(state, LUA_REGISTRYINDEX, it->second.function);
+            it = lua_timers.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
@@ -15,13 +15,12 @@
  * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
  */
 
+#include <vulpes/functions/thunks.hpp>
 #include <vulpes/memory/signatures.hpp>
 
 #include "network_id.hpp"
 
 static uintptr_t message_delta_object_index;
-static uintptr_t func_server_register_network_index;
-static uintptr_t func_client_register_network_index_from_remote;
 static uintptr_t func_unregister_network_index;
 
 // Pointer to a pointer because the game might change the actual pointer
@@ -34,38 +33,13 @@ int32_t server_register_network_index(MemRef object) {
         // Just don't even try if we're at max capacity.
         return -1;
     }
-    int32_t network_id;
-    asm (
-        // Put arguments where Halo's custom calling convention expects them.
-        "mov eax, %[synced_objects];"
-        "push %[local_object_id];" // esp - 4
-        "call %[server_register_network_index];"
-        "mov %[network_id], eax;" // Get return value.
-        "add esp, 4;" // Sync stack to before the push
-        :
-        : [synced_objects] "m" (synced_objects),
-          [network_id] "m" (network_id),
-          [local_object_id] "m" (object.raw),
-          [server_register_network_index] "m" (func_server_register_network_index)
-    );
-    return network_id;
+    return call_server_register_network_index(synced_objects, object.raw);
 }
 
 void register_network_index_from_remote(int32_t network_id, MemRef object) {
     SyncedObjectHeader* synced_objects = *synced_objects_header;
-    asm (
-        // Put arguments where Halo's custom calling convention expects them.
-        "mov eax, %[synced_objects];"
-        "mov ecx, %[local_object_id];"
-        "push %[network_id];" // esp - 4
-        "call %[client_register_network_index_from_remote];"
-        "add esp, 4;" // Sync stack to before the push
-        :
-        : [synced_objects] "m" (synced_objects),
-          [local_object_id] "m" (object.raw),
-          [network_id] "m" (network_id),
-          [client_register_network_index_from_remote] "m" (func_client_register_network_index_from_remote)
-    );
+    call_client_register_network_index_from_remote(
+        synced_objects, object.raw, network_id);
 }
 
 void unregister_network_index(MemRef object) {
@@ -113,10 +87,6 @@ int32_t get_network_id_from_object(MemRef object) {
 void init_network_id() {
     synced_objects_header = *reinterpret_cast<SyncedObjectHeader***>(
         sig_network_translation_table());
-    func_server_register_network_index =
-        sig_func_server_register_network_index();
-    func_client_register_network_index_from_remote =
-        sig_func_client_register_network_index_from_remote();
     func_unregister_network_index =
         sig_func_unregister_network_index();
 }
@@ -24,3 +24,13 @@
 #define LUA_MAP_PATH    VULPES_PATH "\\lua\\map"
 
 #define LUA_GLOBAL_PATH VULPES_PATH "\\lua\\global"
+
+#define LOG_PATH        VULPES_PATH "\\logs"
+
+#define SCRIPT_PATH     VULPES_PATH "\\scripts"
+
+#define TICK_PROFILE_PATH VULPES_PATH "\\tick_profile.csv"
+
+// This one is relative to the directory of the executable instead of the
+// profile path, as we need it before the game knows its profile path.
+#define SIGNATURE_CACHE_PATH VULPES_PATH "\\signatures.cache"
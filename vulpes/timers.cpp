@@ -0,0 +1,213 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#include <vector>
+
+#include "timers.hpp"
+
+// Four wheels of 256 slots. A slot of the first wheel is one tick, a slot of
+// the next is a full turn of the one before. Timers too far away for the
+// first wheel wait in the others, and move down when their slot comes up.
+static const int WHEELS = 4;
+static const int WHEEL_BITS = 8;
+static const uint32_t SLOTS = 1 << WHEEL_BITS;
+static const uint32_t SLOT_MASK = SLOTS - 1;
+
+// Every slot is a circular list of timers, with a node of its own to start
+// from, so a timer can be taken out without knowing which slot it is in.
+// Timers are linked by index, so the nodes can grow without breaking links.
+static const uint32_t FIRING = WHEELS * SLOTS;
+static const uint32_t FIRST_TIMER = FIRING + 1;
+
+// Generations are kept to 20 bits, so handles fit in a Lua number.
+static const uint32_t GENERATION_MASK = 0xFFFFF;
+
+struct TimerNode {
+    uint32_t prev;
+    uint32_t next;
+    uint32_t generation;
+    // 0 for timers that only run once.
+    uint32_t interval;
+    uint64_t when;
+    TimerFunction function;
+    void* context;
+    bool active;
+};
+
+static std::vector<TimerNode> nodes;
+static uint32_t free_nodes = 0;
+static uint64_t now = 0;
+
+static void init_nodes() {
+    nodes.resize(FIRST_TIMER);
+    for (uint32_t i = 0; i < FIRST_TIMER; i++) {
+        nodes[i].prev = i;
+        nodes[i].next = i;
+    }
+}
+
+static void unlink(uint32_t node) {
+    auto& n = nodes[node];
+    nodes[n.prev].next = n.next;
+    nodes[n.next].prev = n.prev;
+    n.prev = node;
+    n.next = node;
+}
+
+static void link(uint32_t list, uint32_t node) {
+    auto& n = nodes[node];
+    n.prev = nodes[list].prev;
+    n.next = list;
+    nodes[n.prev].next = node;
+    nodes[list].prev = node;
+}
+
+// Puts a timer in the slot of the smallest wheel that reaches it.
+static void place(uint32_t node) {
+    uint64_t when = nodes[node].when;
+    uint64_t delta = when > now ? when - now : 0;
+    int wheel = 0;
+    while (wheel < WHEELS - 1 && delta >= (uint64_t(1) << (WHEEL_BITS * (wheel + 1)))) {
+        wheel++;
+    }
+    uint32_t slot = (when >> (WHEEL_BITS * wheel)) & SLOT_MASK;
+    link(wheel * SLOTS + slot, node);
+}
+
+static TimerHandle handle_of(uint32_t node) {
+    return (uint64_t(nodes[node].generation) << 32) | node;
+}
+
+static uint32_t node_of(TimerHandle timer) {
+    uint32_t node = timer & 0xFFFFFFFF;
+    if (node < FIRST_TIMER || node >= nodes.size()) return 0;
+    auto& n = nodes[node];
+    if (!n.active || n.generation != (timer >> 32)) return 0;
+    return node;
+}
+
+static TimerHandle start_timer(uint32_t ticks, uint32_t interval,
+                               TimerFunction function, void* context) {
+    if (!function) return 0;
+    if (nodes.empty()) init_nodes();
+
+    uint32_t node;
+    if (free_nodes) {
+        node = free_nodes;
+        free_nodes = nodes[node].next;
+    } else {
+        node = nodes.size();
+        nodes.push_back(TimerNode());
+        nodes[node].generation = 0;
+    }
+    auto& n = nodes[node];
+    n.prev = node;
+    n.next = node;
+    n.generation = (n.generation + 1) & GENERATION_MASK;
+    n.interval = interval;
+    n.when = now + (ticks ? ticks : 1);
+    n.function = function;
+    n.context = context;
+    n.active = true;
+    place(node);
+    return handle_of(node);
+}
+
+static void free_timer(uint32_t node) {
+    nodes[node].active = false;
+    nodes[node].next = free_nodes;
+    free_nodes = node;
+}
+
+TimerHandle timer_after(uint32_t ticks, TimerFunction function, void* context) {
+    return start_timer(ticks, 0, function, context);
+}
+
+TimerHandle timer_every(uint32_t ticks, TimerFunction function, void* context) {
+    if (ticks == 0) ticks = 1;
+    return start_timer(ticks, ticks, function, context);
+}
+
+bool timer_cancel(TimerHandle timer) {
+    uint32_t node = node_of(timer);
+    if (!node) return false;
+    unlink(node);
+    free_timer(node);
+    return true;
+}
+
+bool timer_active(TimerHandle timer) {
+    return node_of(timer) != 0;
+}
+
+uint64_t timer_ticks() {
+    return now;
+}
+
+// Moves all timers of a slot to where they belong now.
+static void cascade(int wheel) {
+    uint32_t slot = (now >> (WHEEL_BITS * wheel)) & SLOT_MASK;
+    uint32_t list = wheel * SLOTS + slot;
+    while (nodes[list].next != list) {
+        uint32_t node = nodes[list].next;
+        unlink(node);
+        place(node);
+    }
+}
+
+void advance_timers() {
+    if (nodes.empty()) {
+        now++;
+        return;
+    }
+    now++;
+
+    // When a wheel comes around, the next one moves a slot down.
+    for (int wheel = 1; wheel < WHEELS; wheel++) {
+        if ((now >> (WHEEL_BITS * (wheel - 1))) & SLOT_MASK) break;
+        cascade(wheel);
+    }
+
+    // Take the slot out first, so timers started by the functions wait for
+    // their own tick, even if that is this slot's next turn.
+    uint32_t slot = now & SLOT_MASK;
+    if (nodes[slot].next == slot) return;
+    nodes[FIRING].next = nodes[slot].next;
+    nodes[FIRING].prev = nodes[slot].prev;
+    nodes[nodes[FIRING].next].prev = FIRING;
+    nodes[nodes[FIRING].prev].next = FIRING;
+    nodes[slot].next = slot;
+    nodes[slot].prev = slot;
+
+    while (nodes[FIRING].next != FIRING) {
+        uint32_t node = nodes[FIRING].next;
+        unlink(node);
+        auto& n = nodes[node];
+        TimerHandle timer = handle_of(node);
+        TimerFunction function = n.function;
+        void* context = n.context;
+        // Repeating timers go back in before the call, so they can cancel
+        // themselves. One time timers are done before it.
+        if (n.interval) {
+            n.when = now + n.interval;
+            place(node);
+        } else {
+            free_timer(node);
+        }
+        function(timer, context);
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of Vulpes, an extension of Halo Custom Edition's capabilities.
+ * Copyright (C) 2019-2020 gbMichelle (Michelle van der Graaf)
+ *
+ * Vulpes is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, version 3.
+ *
+ * Vulpes is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Runs functions a number of ticks from now, once or over and over.
+//
+// Timers live in a hierarchical timing wheel that is turned once after every
+// tick. Starting and cancelling a timer takes the same time no matter how
+// many there are, and a tick where nothing is due costs next to nothing.
+
+// Identifies a started timer. 0 is never a timer. Handles of timers that
+// finished or got cancelled stay invalid, they don't get reused for a long
+// while.
+typedef uint64_t TimerHandle;
+
+// Gets the handle of the timer that called it, so it can cancel itself.
+typedef void (*TimerFunction)(TimerHandle timer, void* context);
+
+// Calls function in ticks ticks. 0 is treated as 1, the next tick.
+TimerHandle timer_after(uint32_t ticks, TimerFunction function, void* context = nullptr);
+
+// Calls function every ticks ticks, starting ticks from now.
+TimerHandle timer_every(uint32_t ticks, TimerFunction function, void* context = nullptr);
+
+// Returns false if the timer already finished or was cancelled.
+bool timer_cancel(TimerHandle timer);
+
+bool timer_active(TimerHandle timer);
+
+// How many ticks the timers have been turned.
+uint64_t timer_ticks();
+
+// Called by the tick hook after every tick.
+void advance_timers();
@@ -15,16 +15,22 @@
  * long with Vulpes.  If not, see <https://www.gnu.org/licenses/agpl-3.0.en.html>
  */
 
-#include <vulpes/hooks/tick.hpp>
 #include <vulpes/memory/gamestate/console.hpp>
+#include <vulpes/timers.hpp>
 
 #include "tweaks.hpp"
 
-void init_tweaks() {
+static TimerHandle tweaks_timer = 0;
+
+static void apply_tweaks(TimerHandle timer, void* context) {
     console_input_globals()->enabled = true;
-    DEL_CALLBACK(EVENT_TICK, init_tweaks);
+}
+
+// The game sets these up itself, so we wait for the first tick.
+void init_tweaks() {
+    tweaks_timer = timer_after(1, &apply_tweaks);
 }
 
 void revert_tweaks() {
-    DEL_CALLBACK(EVENT_TICK, init_tweaks);
+    timer_cancel(tweaks_timer);
 }
@@ -43,6 +43,7 @@
     our and vanilla memory that does all the things Halo normally does.
 */
 
+#include <atomic>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
@@ -53,6 +54,8 @@
 #include <vulpes/memory/global.hpp>
 #include <vulpes/memory/signatures.hpp>
 #include <vulpes/memory/gamestate/table.hpp>
+#include <vulpes/hooks/map.hpp>
+#include <vulpes/jobs.hpp>
 
 #include "gamestate.hpp"
 
@@ -240,14 +243,150 @@ static void game_state_upgrade_read_from_file(char* filepath) {
     fclose(save_file);
 }
 
-/* saves the upgraded gamestate to the given filepath */
-static void game_state_upgrade_write_to_file(char* filepath) {
-    FILE* save_file = fopen(filepath, "wb");
+/* saves the upgraded gamestate next to the given filepath, to filepath with
+   temp_suffix added. move_checkpoint_file then puts it in place, so a write
+   that gets cut off halfway never leaves a broken file behind. */
+static bool game_state_upgrade_write_to_file(const char* filepath, const char* temp_suffix) {
+    char temp_path[PATH_CHARS];
+    if (snprintf(temp_path, PATH_CHARS, "%s%s", filepath, temp_suffix) >= PATH_CHARS) {
+        return false;
+    }
+    FILE* save_file = fopen(temp_path, "wb");
+    if (!save_file) return false;
     // Just dump the entire upgrade memory into one file.
-    fwrite(gamestate_extension_checkpoint_buffer, 1, ALLOCATED_UPGRADE_MEMORY, save_file);
+    size_t written = fwrite(gamestate_extension_checkpoint_buffer, 1, ALLOCATED_UPGRADE_MEMORY, save_file);
     // Flush and close.
-    fflush(save_file);
-    fclose(save_file);
+    bool success = fflush(save_file) == 0 && written == ALLOCATED_UPGRADE_MEMORY;
+    success = fclose(save_file) == 0 && success;
+    if (!success) {
+        DeleteFile(temp_path);
+        return false;
+    }
+    return true;
+}
+
+/* Replaces filepath with the temporary file, or only removes the temporary
+   file if keep is false. */
+static bool move_checkpoint_file(const char* filepath, const char* temp_suffix, bool keep) {
+    char temp_path[PATH_CHARS];
+    snprintf(temp_path, PATH_CHARS, "%s%s", filepath, temp_suffix);
+    if (!keep) {
+        DeleteFile(temp_path);
+        return false;
+    }
+    return MoveFileEx(temp_path, filepath,
+                      MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+}
+
+/*
+    Writing 10MB twice can take a while, so our checkpoint files are written
+    by a worker and the game doesn't have to wait on the disk. The worker
+    reads straight from the checkpoint buffer, so everything that touches
+    that buffer or our files waits for the write to be done first.
+*/
+static std::atomic<bool> checkpoint_writing(false);
+
+struct CheckpointWrite {
+    char main_path[PATH_CHARS];
+    char profile_path[PATH_CHARS];
+    bool success;
+};
+
+// The write that was handed to a worker last. queued_write is only set until
+// someone starts on it, whoever takes it out of there does the write.
+static CheckpointWrite* current_write = NULL;
+static std::atomic<CheckpointWrite*> queued_write(NULL);
+
+// Who gets to move finished files into place. Once shutdown gave up on a
+// worker and took over, that worker must not replace any files anymore.
+enum CheckpointMover {
+    CHECKPOINT_MOVER_NONE,
+    CHECKPOINT_MOVER_WORKER,
+    CHECKPOINT_MOVER_SHUTDOWN
+};
+static std::atomic<int> checkpoint_mover(CHECKPOINT_MOVER_NONE);
+
+// How long we wait on a worker at shutdown before writing it ourselves.
+static const int CHECKPOINT_SHUTDOWN_WAIT_MS = 1000;
+
+// Writes both files to temporary ones, then moves them in if mover gets to.
+static bool write_checkpoint_files(CheckpointWrite* write, const char* temp_suffix,
+                                   CheckpointMover mover) {
+    bool written = game_state_upgrade_write_to_file(write->main_path, temp_suffix)
+                && game_state_upgrade_write_to_file(write->profile_path, temp_suffix);
+    int expected = CHECKPOINT_MOVER_NONE;
+    bool keep = mover == CHECKPOINT_MOVER_SHUTDOWN
+             || checkpoint_mover.compare_exchange_strong(expected, mover);
+    bool moved = move_checkpoint_file(write->main_path, temp_suffix, written && keep);
+    moved = move_checkpoint_file(write->profile_path, temp_suffix, written && keep && moved) && moved;
+    if (keep && mover == CHECKPOINT_MOVER_WORKER) {
+        checkpoint_mover = CHECKPOINT_MOVER_NONE;
+    }
+    return moved;
+}
+
+static void wait_for_checkpoint_write() {
+    while (checkpoint_writing) {
+        Sleep(1);
+    }
+}
+
+static bool wait_for_checkpoint_write_for(int milliseconds) {
+    for (int waited = 0; checkpoint_writing && waited < milliseconds; waited++) {
+        Sleep(1);
+    }
+    return !checkpoint_writing;
+}
+
+/*
+    At shutdown the workers can't be trusted to finish. stop_workers drops
+    jobs that haven't started, and on exit Windows kills every other thread
+    before we get to clean up. So a write no worker took yet is done right
+    here. If one that is underway doesn't finish in time we write it again
+    to our own temporary files and keep the worker from moving its files in
+    after that. It may still be reading the checkpoint buffer though, so
+    then we return false and the buffer must not be freed.
+*/
+bool finish_gamestate_checkpoint_write() {
+    // We already took over from a worker that is stuck.
+    if (checkpoint_mover == CHECKPOINT_MOVER_SHUTDOWN) return !checkpoint_writing;
+    auto write = queued_write.exchange(NULL);
+    if (write) {
+        if (!write_checkpoint_files(write, ".tmp", CHECKPOINT_MOVER_WORKER)) {
+            printf("Couldn't write the Vulpes checkpoint files.\n");
+        }
+        checkpoint_writing = false;
+        return true;
+    }
+    if (wait_for_checkpoint_write_for(CHECKPOINT_SHUTDOWN_WAIT_MS)) return true;
+
+    int expected = CHECKPOINT_MOVER_NONE;
+    if (checkpoint_mover.compare_exchange_strong(expected, CHECKPOINT_MOVER_SHUTDOWN)) {
+        if (!write_checkpoint_files(current_write, ".exit.tmp", CHECKPOINT_MOVER_SHUTDOWN)) {
+            printf("Couldn't write the Vulpes checkpoint files.\n");
+        }
+    } else {
+        // It's moving its files in right now, which doesn't take long.
+        wait_for_checkpoint_write_for(CHECKPOINT_SHUTDOWN_WAIT_MS);
+    }
+    return !checkpoint_writing;
+}
+
+static void checkpoint_write_work(void* data) {
+    auto write = reinterpret_cast<CheckpointWrite*>(data);
+    // Shutdown might have beaten us to it.
+    auto expected = write;
+    if (!queued_write.compare_exchange_strong(expected, NULL)) return;
+    write->success = write_checkpoint_files(write, ".tmp", CHECKPOINT_MOVER_WORKER);
+    checkpoint_writing = false;
+}
+
+static void checkpoint_write_done(void* data) {
+    auto write = reinterpret_cast<CheckpointWrite*>(data);
+    if (!write->success) {
+        printf("Couldn't write the Vulpes checkpoint files.\n");
+    }
+    delete write;
 }
 
 extern "C"
@@ -262,6 +401,7 @@ void gamestate_read_from_main_file_hook() {
 
     // Read directly from the main savefile extension
 
+    wait_for_checkpoint_write();
     game_state_upgrade_read_from_file(path);
 }
 
@@ -277,6 +417,7 @@ void gamestate_read_from_profile_file_hook() {
 
     // Read directly from the main savefile extension
 
+    wait_for_checkpoint_write();
     game_state_upgrade_read_from_file(path);
 }
 
@@ -284,26 +425,28 @@ extern "C"
 /* Halo always saved to both the main save file and to the profile savefile
    that is why we do both at once here */
 void gamestate_write_to_files_hook() {
-    char path[PATH_CHARS];
+    // The paths come from the game, so we get them here.
+    auto write = new CheckpointWrite;
 
     // Find the path where the main savefile goes.
 
-    strncpy(path, profile_path(), PATH_CHARS);
-    strncat(path, SAVE_PATH,      PATH_CHARS);
-
-    // Dump to the main savefile extension
-
-    game_state_upgrade_write_to_file(path);
+    strncpy(write->main_path, profile_path(), PATH_CHARS);
+    strncat(write->main_path, SAVE_PATH,      PATH_CHARS);
 
     // Find the path where profile specific savefiles go
 
-    memset(path, 0, PATH_CHARS);
-    saved_game_file_get_path_to_enclosing_directory(active_profile_id(), path);
-    strncat(path, SAVE_PATH, PATH_CHARS);
+    memset(write->profile_path, 0, PATH_CHARS);
+    saved_game_file_get_path_to_enclosing_directory(active_profile_id(), write->profile_path);
+    strncat(write->profile_path, SAVE_PATH, PATH_CHARS);
 
-    // Dump to the profile specific savefile extension
+    // Dump to both savefile extensions in the background.
 
-    game_state_upgrade_write_to_file(path);
+    wait_for_checkpoint_write();
+    write->success = true;
+    current_write = write;
+    queued_write = write;
+    checkpoint_writing = true;
+    run_job(&checkpoint_write_work, &checkpoint_write_done, write);
 }
 
 extern "C" __attribute__((regparm(2)))
@@ -323,12 +466,15 @@ char gamestate_copy_checkpoint_file_hook(char* to, char* base_path, char* from)
     snprintf(full_path1, PATH_CHARS, "%s%s.vulpes", base_path, from);
     snprintf(full_path2, PATH_CHARS, "%s%s.vulpes", base_path, to);
 
+    wait_for_checkpoint_write();
     CopyFile(full_path2, full_path1, 0);
 
     return 1;
 }
 
 static void gamestate_copy_to_backup_buffer_hook() {
+    // The last checkpoint might still be being written from this buffer.
+    wait_for_checkpoint_write();
     // Copy the vanilla gamestate into the checkpoint buffer.
     // We're replacing the vanilla mechanism for this because there isn't
     // really a great place to hook this function. So, we replaced the code
@@ -439,6 +585,9 @@ void init_gamestate_upgrades() {
     assert(gamestate_extension_checkpoint_buffer);
 
     memset(gamestate_extension_buffer, 0, ALLOCATED_UPGRADE_MEMORY);
+
+    // Don't let a checkpoint write run into the next map.
+    ADD_CALLBACK(EVENT_PRE_MAP_LOAD, wait_for_checkpoint_write);
 }
 
 void revert_gamestate_upgrades() {
@@ -452,7 +601,13 @@ void revert_gamestate_upgrades() {
     patch_gamestate_read_from_main_file_hook.revert();
     patch_gamestate_new_replacement.revert();
 
+    DEL_CALLBACK(EVENT_PRE_MAP_LOAD, wait_for_checkpoint_write);
+
     VirtualFree(gamestate_extension_buffer, ALLOCATED_UPGRADE_MEMORY, MEM_RELEASE);
-    VirtualFree(gamestate_extension_checkpoint_buffer, ALLOCATED_UPGRADE_MEMORY, MEM_RELEASE);
+    // A worker that is stuck writing still reads from the checkpoint buffer,
+    // so in that case it's better to leak it.
+    if (finish_gamestate_checkpoint_write()) {
+        VirtualFree(gamestate_extension_checkpoint_buffer, ALLOCATED_UPGRADE_MEMORY, MEM_RELEASE);
+    }
 
 }
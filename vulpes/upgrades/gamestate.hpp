@@ -19,6 +19,10 @@
 
 void init_gamestate_upgrades();
 void revert_gamestate_upgrades();
+// Makes sure the last checkpoint made it to disk, even if the workers
+// are gone already. For shutdown. Returns false if a worker might still be
+// reading the checkpoint buffer.
+bool finish_gamestate_checkpoint_write();
 
 /* Another mod might have caused these to be different.
  * So, don't use these for loops and size checks.
@@ -52,9 +52,11 @@ void revert_hooks() {
 // Commands
 
 #include "command/debug.hpp"
+#include "command/script.hpp"
 #include "command/server.hpp"
 void init_commands() {
     init_debug_commands();
+    init_script_commands();
     init_server_commands();
 }
 
@@ -77,7 +79,7 @@ void init_halo_bug_fixes() {
         init_framerate_dependent_timer_fixes();
         ADD_CALLBACK(EVENT_MAP_LOAD_SP_UI, init_animation_bug_fixes);
         init_loading_screen_fixes();
-        ADD_CALLBACK(EVENT_TICK, init_tweaks);
+        init_tweaks();
     }
 }
 
@@ -128,26 +130,35 @@ void init_network() {
 
 // Main init.
 
+#include <string>
+
+#include <util/crc32.hpp>
+#include <util/file_helpers.hpp>
 #include <util/fox.hpp>
 #include <hooker/hooker.hpp>
+#include <hooker/patch_set.hpp>
+#include <hooker/pe.hpp>
+#include <hooker/signature_cache.hpp>
 
 #include "functions/messaging.hpp"
 #include "lua/lua.hpp"
+#include "jobs.hpp"
+#include "log.hpp"
+#include "paths.hpp"
 
 void pre_first_map_load_init();
 
-static LiteSignature signature_text_segment_data = {
-    "text_segment_data", 8, { 0x2E, 0x74, 0x65, 0x78, 0x74, 0x00, 0x00, 0x00 } };
-
-struct ImageSectionHeader {
-    uint32_t bullshit1[4];
-    uint32_t size_of_segment;
-    uint32_t offset_to_segment;
-    uint32_t bullshit2[4];
-};
-
+#include <vulpes/functions/thunks.hpp>
 #include <vulpes/memory/signatures.hpp>
 
+// Returns the directory the game executable is in, without a trailing slash.
+static std::string executable_directory() {
+    char path[MAX_PATH];
+    GetModuleFileName(NULL, path, MAX_PATH);
+    auto path_str = std::string(path);
+    return path_str.substr(0, path_str.find_last_of("\\/"));
+}
+
 void init_vulpes() {
     // Let our friend say hello <3
     printf(_FOX);
@@ -155,36 +166,66 @@ void init_vulpes() {
     // Get safe search bounds for CodeSignature.
 
     auto base_module_memory_location = 0x400000;
-    auto module_header_size = 0x401000;
-
-    ImageSectionHeader* segment_header = reinterpret_cast<ImageSectionHeader*>(
-        signature_text_segment_data.search(
-            base_module_memory_location, module_header_size)
-    );
+    // The headers all fit in the first page of the image.
+    auto module_header_size = 0x1000;
+
+    std::vector<PeSection> sections;
+    uint32_t image_size = 0;
+    const PeSection* text_section = NULL;
+    auto module_headers = reinterpret_cast<const uint8_t*>(base_module_memory_location);
+    if (pe_read_sections(module_headers, module_header_size, &sections)
+    && pe_read_image_size(module_headers, module_header_size, &image_size)) {
+        text_section = pe_find_section(sections, ".text");
+    }
 
-    if (!segment_header) {
-        printf("Couldn't find text_segment_data, we won't know where to search "
+    if (!text_section) {
+        printf("Couldn't find the .text section, we won't know where to search "
                "for our signatures now.\n This is unacceptable and we need to "
                "close!\n");
         exit(0);
     }
 
+    // Signatures can ask to only be searched for in a specific section.
+    set_executable_sections(base_module_memory_location, image_size, sections);
+
     // These are the addresses that the base module's code starts and ends.
     // There is no reason to search anywhere else. That's just dangerous.
 
     set_lowest_permitted_address(
         base_module_memory_location
-        + segment_header->offset_to_segment
+        + text_section->virtual_address
     );
     set_highest_permitted_address(
         base_module_memory_location
-        + segment_header->offset_to_segment
-        + segment_header->size_of_segment
+        + text_section->virtual_address
+        + text_section->size()
+    );
+
+    // The code of the executable doesn't change between launches, so if
+    // the fingerprint matches we can reuse the signature results from the
+    // last time we were loaded.
+
+    uintptr_t code_start = get_lowest_permitted_address();
+    size_t code_size = get_highest_permitted_address() - code_start;
+    make_dir(executable_directory() + VULPES_PATH);
+
+    static SignatureCache signature_cache(
+        executable_directory() + SIGNATURE_CACHE_PATH,
+        crc32(0, reinterpret_cast<void*>(code_start), code_size)
     );
+    signature_cache.load();
+    set_signature_cache(&signature_cache);
 
     // Initialize the mod
 
     init_signatures_signatures();
+    // Thunks for calling Halo functions get their addresses from signatures.
+    init_thunks_functions();
+
+    // Most patches are applied here, many of them on the same pages.
+    // Queue them up so every page only needs its protection changed once.
+    PatchSet init_patches;
+    open_patch_set(&init_patches);
 
     init_memory();
     init_hooks();
@@ -194,6 +235,9 @@ void init_vulpes() {
     init_network();
     init_commands();
 
+    close_patch_set();
+    init_patches.commit();
+
     // Final initialization step for things that act on data that isn't valid
     // until way later when the game has loaded more.
     ADD_CALLBACK(EVENT_PRE_MAP_LOAD, pre_first_map_load_init);
@@ -202,6 +246,11 @@ void init_vulpes() {
 void pre_first_map_load_init() {
     DEL_CALLBACK(EVENT_PRE_MAP_LOAD, pre_first_map_load_init);
 
+    // The profile path is known by now, so we can start writing the log.
+    make_dir(std::string(profile_path()) + VULPES_PATH);
+    make_dir(std::string(profile_path()) + LOG_PATH);
+    init_log((std::string(profile_path()) + LOG_PATH).data());
+
     // Initialize lua.
     // TODO: Potentially find better place for this that will also load on the
     // server if the server has no decided to load a map yet.
@@ -212,11 +261,24 @@ void pre_first_map_load_init() {
 }
 
 void destruct_vulpes() {
+    // The last checkpoint could still be on its way to disk, and reverting
+    // frees the memory it is written from.
+    finish_gamestate_checkpoint_write();
+
+    PatchSet revert_patches;
+    open_patch_set(&revert_patches);
+
     revert_hooks();
     revert_halo_bug_fixes();
     revert_upgrades();
     revert_halo_bug_fixes();
+
+    close_patch_set();
+    revert_patches.commit();
+
     destruct_lua();
+    stop_workers();
+    stop_log();
 }
 
 // DLL Entrypoint.